@@ -6,6 +6,47 @@ static const float ZOOM_MIN       = 10;
 static const float ZOOM_MAX       = 400;
 static const float SCROLL_STEP    = 40;
 static const float TRANSPARENCY   = 0.4;
+static const int   READAHEAD_SIZE = 1024 * 1024; /* bytes read ahead at both ends of a file */
+static const int   LOAD_STEP      = 32;          /* pages enumerated per idle call after opening */
+static const int   STREAM_INTERVAL = 500;        /* ms between two parses of a growing file */
+static const int   DOCUMENT_CACHE = 8;           /* closed documents a server keeps parsed */
+static const int   CACHE_SIZE     = 64;          /* MiB of rendered pages, see the cache_size setting */
+static const int   PACKED_SIZE    = 32;          /* MiB of compressed pages, see the packed_size setting */
+static const int   POOL_SIZE      = 32;          /* MiB of idle surface buffers kept for reuse */
+static const int   HUGE_PAGE_SIZE = 2 * 1024 * 1024; /* buffers of this size use transparent huge pages */
+static const int   TILES          = 1;           /* bands a page is rendered in at once, 0 means one per processor */
+static const int   RECORDING_SIZE = 32;          /* MiB of display lists, see the recording_size setting */
+static const int   RECORDING_PAGES = 64;         /* display lists kept at most, their size is only estimated */
+static const int   RECORDING_DPI  = 150;         /* resolution the images of a display list are estimated at */
+static const int   DISK_CACHE_SIZE = 256;        /* MiB of rendered pages on disk, 0 disables them */
+static const int   CGROUP_SHARE   = 4;           /* the cache takes at most 1/n of the cgroup memory limit */
+
+/* overview */
+static const int   THUMBNAIL_WIDTH   = 150;      /* size of a cell in the overview grid */
+static const int   THUMBNAIL_HEIGHT  = 200;
+static const int   THUMBNAIL_PADDING = 10;
+static const int   THUMBNAIL_CACHE   = 32;       /* MiB of thumbnails */
+static const int   OVERVIEW_WORKERS  = 2;        /* documents thumbnails are rendered from at once */
+
+/* background jobs */
+static const int   SCHEDULER_WORKERS = 2;        /* threads that load, prefetch, search and render thumbnails */
+static const int   SCHEDULER_AGING   = 4;        /* jobs of a higher class that may pass a waiting one */
+
+/* prefetching */
+static const int   PREFETCH_DEPTH = 8;           /* spreads that are rendered ahead at most */
+static const int   READING_TIME   = 2000;        /* ms spent on a page until the reader has been measured */
+static const int   READING_PAUSE  = 60000;       /* ms on a page that count as a break instead */
+static const int   JUMP_DELAY     = 500;         /* ms on a page before the targets of links, markers and bookmarks are rendered */
+static const int   JUMP_TARGETS   = 8;           /* pages that are rendered ahead for jumps at most */
+
+/* memory pressure */
+static const char  PRESSURE_FILE[]    = "/proc/pressure/memory";
+static const char  PRESSURE_TRIGGER[] = "some 150000 2000000"; /* 150ms stall within 2s, unprivileged triggers need a multiple of 2s */
+static const float PRESSURE_THRESHOLD = 10;      /* avg10 in percent if the file has to be polled */
+static const int   PRESSURE_INTERVAL  = 2000;    /* ms between two polls */
+static const int   PRESSURE_RECOVERY  = 10000;   /* ms without pressure before caching resumes */
+static const int   RENDER_WORKERS = 4;           /* connections the render daemon serves at once */
+static const int   RENDER_BUDGET  = 256;         /* MiB of documents and rasters the render daemon keeps */
 
 /* completion */
 static const char FORMAT_COMMAND[]     = "<b>%s</b>";
@@ -13,11 +54,17 @@ static const char FORMAT_DESCRIPTION[] = "<i>%s</i>";
 
 /* directories and files */
 static const char ZATHURA_DIR[]   = ".zathura";
-static const char BOOKMARK_FILE[] = "bookmarks";
+static const char BOOKMARK_FILE[] = "bookmarks";   /* only read to migrate old bookmarks */
+static const char BOOKMARK_DIR[]  = "bookmarks.d";
+static const char DISK_CACHE_DIR[] = "cache";     /* rendered pages, see the disk_cache_size setting */
+static const char SERVER_SOCKET[] = "zathura.socket";  /* in the user runtime directory */
+static const char RENDER_SOCKET[] = "zathura-render.socket";
 
 /* bookmarks */
 static const char BM_PAGE_ENTRY[]  = "page";
 static const char BM_PAGE_OFFSET[] = "offset";
+static const char COST_SUFFIX[]    = ".costs";    /* render times, next to the journal of a document */
+static const int  BM_COMPACT       = 64;         /* stale journal records before it is rewritten */
 
 /* look */
 static const char font[]                   = "monospace normal 9";
@@ -49,6 +96,14 @@ static const char DEFAULT_TEXT[] = "[No Name]";
 #define LIST_PRINTER_COMMAND "lpstat -v | sed -n '/^.*device for \\(.*\\): .*$/s//\\1/p'"
 #define PRINT_COMMAND "lp -d '%s' -p %s '%s'" /* printer / pages / file */
 
+/* decompression */
+Decompressor decompressors[] = {
+  /* suffix,     command */
+  {".gz",        "gzip -dc %s" },   /* file */
+  {".bz2",       "bzip2 -dc %s" },  /* file */
+  {".xz",        "xz -dc %s" },     /* file */
+};
+
 /* open uri */
 #define URI_COMMAND "firefox %s" /* uri */
 
@@ -56,6 +111,10 @@ static const char DEFAULT_TEXT[] = "[No Name]";
 #define SHOW_SCROLLBARS 0
 #define ADJUST_OPEN ADJUST_BESTFIT
 #define RECOLOR_OPEN 0
+#define MMAP_OPEN 0 /* hand a memory mapped file to poppler, a file truncated while mapped kills zathura */
+#define STREAM_OPEN 0 /* follow files that are still being written */
+#define SPREAD_OPEN 0 /* show two pages side by side */
+#define SPREAD_COVER 1 /* the first page of a spread is shown on its own */
 #define GOTO_MODE GOTO_LABELS /* GOTO_DEFAULT, GOTO_LABELS, GOTO_OFFSET */
 
 /* shortcuts */
@@ -66,6 +125,9 @@ Shortcut shortcuts[] = {
   {GDK_CONTROL_MASK,   GDK_q,             sc_quit,              -1,       {0} },
   {GDK_CONTROL_MASK,   GDK_c,             sc_abort,             -1,       {0} },
   {GDK_CONTROL_MASK,   GDK_i,             sc_recolor,           NORMAL,   {0} },
+  {0,                  GDK_F5,            sc_toggle_presentation, NORMAL, {0} },
+  {GDK_CONTROL_MASK,   GDK_o,             sc_toggle_overview,   NORMAL,   {0} },
+  {GDK_CONTROL_MASK,   GDK_o,             sc_toggle_overview,   OVERVIEW, {0} },
   {0,                  GDK_slash,         sc_focus_inputbar,    NORMAL,   { .data = "/" } },
   {GDK_SHIFT_MASK,     GDK_slash,         sc_focus_inputbar,    NORMAL,   { .data = "/" } },
   {GDK_SHIFT_MASK,     GDK_question,      sc_focus_inputbar,    NORMAL,   { .data = "?" } },
@@ -105,6 +167,16 @@ Shortcut shortcuts[] = {
   {0,                  GDK_l,             sc_navigate_index,    INDEX,    { EXPAND } },
   {0,                  GDK_space,         sc_navigate_index,    INDEX,    { SELECT } },
   {0,                  GDK_Return,        sc_navigate_index,    INDEX,    { SELECT } },
+  {0,                  GDK_h,             sc_navigate_overview, OVERVIEW, { LEFT } },
+  {0,                  GDK_j,             sc_navigate_overview, OVERVIEW, { DOWN } },
+  {0,                  GDK_k,             sc_navigate_overview, OVERVIEW, { UP } },
+  {0,                  GDK_l,             sc_navigate_overview, OVERVIEW, { RIGHT } },
+  {0,                  GDK_Left,          sc_navigate_overview, OVERVIEW, { LEFT } },
+  {0,                  GDK_Down,          sc_navigate_overview, OVERVIEW, { DOWN } },
+  {0,                  GDK_Up,            sc_navigate_overview, OVERVIEW, { UP } },
+  {0,                  GDK_Right,         sc_navigate_overview, OVERVIEW, { RIGHT } },
+  {0,                  GDK_space,         sc_navigate_overview, OVERVIEW, { SELECT } },
+  {0,                  GDK_Return,        sc_navigate_overview, OVERVIEW, { SELECT } },
 };
 
 /* inputbar shortcuts */
@@ -125,13 +197,18 @@ Command commands[] = {
   /* command,   abbreviation,   function,            completion,   description  */
   {"bmark",     "b",            cmd_bookmark,        0,            "Bookmark current page" },
   {"blist",     0,              cmd_open_bookmark,   cc_bookmark,  "List and open bookmark" },
+  {"bench",     0,              cmd_bench,           0,            "Compare rendering and replaying the page" },
+  {"cache",     0,              cmd_cache,           0,            "Show cache statistics" },
   {"close",     "c",            cmd_close,           0,            "Close current file" },
   {"coffset",   0,              cmd_correct_offset,  0,            "Correct page offset" },
   {"delbmark",  0,              cmd_delete_bookmark, cc_bookmark,  "Bookmark current page" },
   {"export",    "e",            cmd_export,          cc_export,    "Export images or attached files" },
+  {"goto",      0,              cmd_goto,            0,            "Go to the given page" },
   {"info",      "i",            cmd_info,            0,            "Show information about the document" },
+  {"jobs",      0,              cmd_jobs,            0,            "Show the background jobs" },
   {"open",      "o",            cmd_open,            cc_open,      "Open a file" },
   {"print",     "p",            cmd_print,           cc_print,     "Print the document" },
+  {"reload",    0,              cmd_reload,          0,            "Reload the document" },
   {"rotate",    "r",            cmd_rotate,          0,            "Rotate the page" },
   {"set",       "s",            cmd_set,             cc_set,       "Set an option" },
   {"quit",      "q",            cmd_quit,            0,            "Quit zathura" },
@@ -160,8 +237,16 @@ SpecialCommand special_commands[] = {
 
 /* settings */
 Setting settings[] = {
-  /* name,         variable,                        type,  render,  description */
-  {"recolor",      &(Zathura.Global.recolor),       'b',   TRUE,    "Invert the image"},
-  {"password",     &(Zathura.PDF.password),         's',   FALSE,   "The password of the document"},
-  {"offset",       &(Zathura.PDF.page_offset),      'i',   FALSE,   "Optional page offset"},
+  /* name,            variable,                        type,  render,  description */
+  {"recolor",         &(Zathura.Global.recolor),       'b',   TRUE,    "Invert the image"},
+  {"stream",          &(Zathura.Global.stream),        'b',   FALSE,   "Follow files that are still being written"},
+  {"password",        &(Zathura.PDF.password),         's',   FALSE,   "The password of the document"},
+  {"offset",          &(Zathura.PDF.page_offset),      'i',   FALSE,   "Optional page offset"},
+  {"cache_size",      &(Zathura.Cache.size),           'i',   TRUE,    "Memory for rendered pages in MiB"},
+  {"packed_size",     &(Zathura.Cache.packed_size),    'i',   FALSE,   "Memory for compressed pages in MiB"},
+  {"recording_size",  &(Zathura.Cache.recording_size), 'i',   FALSE,   "Memory for display lists in MiB"},
+  {"disk_cache_size", &(Zathura.Disk.size),            'i',   FALSE,   "Disk space for rendered pages in MiB"},
+  {"spread",          &(Zathura.Global.spread),        'b',   TRUE,    "Show two pages side by side"},
+  {"spread_cover",    &(Zathura.Global.spread_cover),  'b',   TRUE,    "Show the first page of a spread on its own"},
+  {"tiles",           &(Zathura.Global.tiles),         'i',   FALSE,   "Number of bands a page is rendered in at once"},
 };
@@ -0,0 +1,54 @@
+#!/bin/sh
+# See LICENSE file for license and copyright information
+# load test for the render daemon: starts CLIENTS clients at once, each of
+# which has the daemon render the pages of FILE, and prints the throughput
+
+if [ $# -lt 1 ]; then
+	echo "usage: $0 FILE [CLIENTS] [PAGES] [SCALE]" >&2
+	exit 1
+fi
+
+FILE=$1
+CLIENTS=${2:-8}
+PAGES=${3:-}
+SCALE=${4:-100}
+ZATHURA=${ZATHURA:-zathura}
+
+OUT=$(mktemp -d) || exit 1
+trap 'rm -rf "$OUT"' EXIT INT TERM
+
+# a daemon that is already running is used as it is
+if ! "$ZATHURA" --client --render "$FILE" --pages 1 --out "$OUT/probe" >/dev/null 2>&1; then
+	"$ZATHURA" --daemon &
+	DAEMON=$!
+	trap 'kill $DAEMON 2>/dev/null; rm -rf "$OUT"' EXIT INT TERM
+	sleep 1
+fi
+
+START=$(date +%s.%N)
+
+i=0
+while [ $i -lt "$CLIENTS" ]; do
+	"$ZATHURA" --client --render "$FILE" ${PAGES:+--pages "$PAGES"} --scale "$SCALE" \
+		--out "$OUT/$i" > "$OUT/client-$i.log" 2>&1 &
+	i=$((i + 1))
+done
+
+FAILED=0
+for job in $(jobs -p); do
+	[ "$job" = "${DAEMON:-}" ] && continue
+	wait "$job" || FAILED=$((FAILED + 1))
+done
+
+END=$(date +%s.%N)
+
+cat "$OUT"/client-*.log
+awk -v start="$START" -v end="$END" -v clients="$CLIENTS" -v failed="$FAILED" '
+	/^Received/ { pages += $2 }
+	END {
+		elapsed = end - start
+		printf "%d clients, %d failed, %d pages in %.2f s (%.1f pages/s)\n",
+			clients, failed, pages, elapsed, (elapsed > 0) ? pages / elapsed : 0
+	}' "$OUT"/client-*.log
+
+[ $FAILED -eq 0 ]
@@ -1,14 +1,23 @@
 /* See LICENSE file for license and copyright information */
 
-#define _BSD_SOURCE || _XOPEN_SOURCE >= 500
+#define _GNU_SOURCE
 
 #include <regex.h>
+#include <errno.h>
 #include <limits.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <libgen.h>
+#include <fcntl.h>
+#include <malloc.h>
+#include <utime.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
 #include <sys/inotify.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 
 #include <poppler/glib/poppler.h>
 #include <cairo.h>
@@ -18,6 +27,9 @@
 
 /* macros */
 #define LENGTH(x) sizeof(x)/sizeof((x)[0])
+#define INOTIFY_BUFFER (16 * (sizeof(struct inotify_event) + NAME_MAX + 1))
+#define DISK_MAGIC "ZATHRST1"
+#define JOB_CLASSES 4
 
 /* enums */
 enum { NEXT, PREVIOUS, LEFT, RIGHT, UP, DOWN,
@@ -28,7 +40,10 @@ enum { NEXT, PREVIOUS, LEFT, RIGHT, UP, DOWN,
        FORWARD, BACKWARD, ADJUST_BESTFIT, ADJUST_WIDTH,
        ADJUST_NONE, CONTINUOUS, DELETE_LAST, ADD_MARKER,
        EVAL_MARKER, INDEX, EXPAND, COLLAPSE, SELECT,
-       GOTO_DEFAULT, GOTO_LABELS, GOTO_OFFSET};
+       GOTO_DEFAULT, GOTO_LABELS, GOTO_OFFSET,
+       PRIORITY_VISIBLE, PRIORITY_PREFETCH, PRIORITY_THUMBNAIL,
+       PRIORITY_BACKGROUND,
+       ADJUST_SCREEN, OVERVIEW};
 
 /* typedefs */
 struct CElement
@@ -110,13 +125,46 @@ typedef struct
   Argument argument;
 } SpecialCommand;
 
+typedef struct
+{
+  char     *data;
+  gsize     length;
+  gboolean  mapped;
+} Mapping;
+
+typedef struct
+{
+  char* suffix;
+  char* command;
+} Decompressor;
+
 typedef struct
 {
   PopplerPage *page;
   int          id;
   char        *label;
+  gsize        recording;
 } Page;
 
+typedef struct
+{
+  int              id;
+  gboolean         refresh;
+  gboolean         input;
+  char            *command;
+  char            *file;
+  char            *password;
+  int              start_page;
+  off_t            size;
+  time_t           mtime;
+  off_t            file_size;
+  int              number_of_pages;
+  Mapping         *mapping;
+  PopplerDocument *document;
+  PopplerPage     *page;
+  GError          *error;
+} Loader;
+
 typedef struct
 {
   char* name;
@@ -138,6 +186,158 @@ typedef struct
   int page;
 } Bookmark;
 
+typedef struct
+{
+  char            *file;
+  time_t           mtime;
+  off_t            size;
+  PopplerDocument *document;
+  Mapping         *mapping;
+} CachedDocument;
+
+typedef struct
+{
+  char            *file;
+  time_t           mtime;
+  off_t            size;
+  GList           *copies;
+  int              parsed;
+  Mapping         *mapping;
+  int              users;
+  gboolean         stale;
+  gboolean         opening;
+} RenderDocument;
+
+typedef struct
+{
+  int              page;
+  int              scale;
+  int              rotate;
+  gboolean         recolor;
+  int              render_scale;
+  int              priority;
+  cairo_surface_t *surface;
+  gsize            size;
+  unsigned int     last_used;
+  guint32          checksum;
+  GList           *aliases;
+} Raster;
+
+typedef struct
+{
+  int              page;
+  int              scale;
+  int              rotate;
+  gboolean         recolor;
+  int              render_scale;
+  cairo_format_t   format;
+  int              width;
+  int              height;
+  guchar          *data;
+  gsize            length;
+  unsigned int     last_used;
+} Packed;
+
+typedef struct
+{
+  int              page;
+  cairo_surface_t *surface;
+  gsize            size;
+  unsigned int     last_used;
+} Recording;
+
+typedef struct
+{
+  char    magic[8];
+  guint32 format;
+  guint32 width;
+  guint32 height;
+  guint32 stride;
+  guint32 render_scale;
+  guint32 checksum;
+  guint64 length;
+  char    padding[24];
+} DiskHeader;
+
+typedef struct
+{
+  char            *path;
+  int              render_scale;
+  cairo_surface_t *surface;
+} DiskRaster;
+
+typedef struct
+{
+  char            *path;
+  time_t           mtime;
+  gsize            size;
+} DiskFile;
+
+typedef struct
+{
+  GThreadFunc       function;
+  gpointer          data;
+  GDestroyNotify    destroy;
+  GCompareDataFunc  compare;
+  int               priority;
+} Job;
+
+typedef struct
+{
+  int              page;
+  int              scale;
+  int              rotate;
+  gboolean         recolor;
+  int              priority;
+  PopplerPage     *source;
+  cairo_surface_t *recording;
+  cairo_surface_t *surface;
+  double           time;
+} Prefetch;
+
+typedef struct
+{
+  int              page;
+  int              generation;
+  cairo_surface_t *surface;
+  gsize            size;
+  unsigned int     last_used;
+} Thumbnail;
+
+typedef struct
+{
+  cairo_format_t   format;
+  int              width;
+  int              height;
+  gsize            size;
+  unsigned char   *data;
+} Buffer;
+
+typedef struct
+{
+  PopplerDocument *document;
+  int              page;
+  int              scale;
+  int              rotate;
+  double           width;
+  double           height;
+  int              y;
+  cairo_surface_t *surface;
+  double           time;
+} Tile;
+
+typedef struct
+{
+  Mapping *mapping;
+  int     *pages;
+  int      number_of_pages;
+  int      next;
+  int      rendered;
+  int      scale;
+  int      rotate;
+  char    *directory;
+} Batch;
+
 /* zathura */
 struct
 {
@@ -154,6 +354,7 @@ struct
     GtkWidget         *index;
     GtkWidget         *information;
     GtkWidget         *drawing_area;
+    GtkWidget         *overview;
   } UI;
 
   struct
@@ -187,12 +388,16 @@ struct
     int      mode;
     int      viewing_mode;
     gboolean recolor;
+    gboolean stream;
+    gboolean spread;
+    gboolean spread_cover;
     gboolean enable_labelmode;
     int       goto_mode;
     GtkLabel *status_text;
     GtkLabel *status_buffer;
     GtkLabel *status_state;
     int       adjust_mode;
+    int       tiles;
   } Global;
 
   struct
@@ -200,6 +405,8 @@ struct
     char* filename;
     char* pages;
     int scroll_percentage;
+    gboolean loading;
+    int goto_page;
   } State;
 
   struct
@@ -211,14 +418,157 @@ struct
 
   struct
   {
-    int wd;
-    int fd;
+    int         wd;
+    int         fd;
+    GIOChannel *channel;
+    guint       watch;
+    guint       reload;
   } Inotify;
 
+  struct
+  {
+    char     *file;
+    char     *password;
+    off_t     size;
+    gboolean  parsing;
+    guint     update;
+  } Stream;
+
+  struct
+  {
+    char       *socket;
+    int         fd;
+    GIOChannel *channel;
+    guint       watch;
+  } Server;
+
+  struct
+  {
+    GList        *documents;
+    GList        *rasters;
+    gsize         used;
+    int           size;
+    unsigned int  clock;
+    guint         prefetch;
+    guint         jumps;
+    GList        *packed;
+    gsize         packed_used;
+    int           packed_size;
+    unsigned int  hits;
+    unsigned int  packed_hits;
+    unsigned int  packed_misses;
+    unsigned int  shared;
+    GList        *recordings;
+    gsize         recordings_used;
+    int           recording_size;
+    GHashTable   *rendered;
+    GHashTable   *prefetching;
+  } Cache;
+
+  struct
+  {
+    char                  *directory;
+    char                  *document;
+    int                    size;
+    gsize                  used;
+    gboolean               counted;
+    unsigned int           hits;
+    GStaticMutex           lock;
+    cairo_user_data_key_t  key;
+  } Disk;
+
+  struct
+  {
+    GThread      **workers;
+    int            count;
+    GMutex        *lock;
+    GCond         *wake;
+    GCond         *finished;
+    GQueue        *queues[JOB_CLASSES];
+    int            skipped[JOB_CLASSES];
+    unsigned int   done[JOB_CLASSES];
+    GList         *running;
+    int            visible;
+  } Scheduler;
+
+  struct
+  {
+    int         fd;
+    GIOChannel *channel;
+    guint       watch;
+    guint       recover;
+    gboolean    active;
+    int         level;
+  } Pressure;
+
+  struct
+  {
+    GList                 *buffers;
+    gsize                  size;
+    GStaticMutex           lock;
+    cairo_user_data_key_t  key;
+    long                   faults;
+    unsigned int           turns;
+  } Pool;
+
+  struct
+  {
+    GThreadPool *pool;
+    GList       *documents;
+    GMutex      *lock;
+    GCond       *released;
+    gsize        documents_size;
+    gsize        rasters_size;
+  } Daemon;
+
+  struct
+  {
+    PopplerDocument **documents;
+    int               count;
+    PopplerDocument  *spread;
+  } Tiles;
+
+  struct
+  {
+    gboolean active;
+    int      adjust_mode;
+    int      scale;
+    gboolean statusbar;
+    gboolean inputbar;
+  } Presentation;
+
+  struct
+  {
+    GAsyncQueue  *documents;
+    gboolean      shared;
+    GHashTable   *thumbnails;
+    GHashTable   *queued;
+    gsize         used;
+    unsigned int  clock;
+    int           generation;
+    int           columns;
+    int           selected;
+    int           first;
+    int           last;
+    gboolean      visible;
+  } Overview;
+
+  struct
+  {
+    GHashTable *pages;
+    char       *file;
+    gboolean    changed;
+    GTimer     *timer;
+    int         last_page;
+    double      interval;
+  } Costs;
+
   struct
   {
     GKeyFile *data;
     char     *file;
+    char     *directory;
+    int       records;
     Bookmark *bookmarks;
     int       number_of_bookmarks;
   } Bookmarks;
@@ -226,15 +576,20 @@ struct
   struct
   {
     PopplerDocument *document;
+    Mapping         *mapping;
     char            *file;
     char            *password;
     Page           **pages;
+    time_t           mtime;
+    off_t            file_size;
     int              page_number;
     int              page_offset;
     int              number_of_pages;
     int              scale;
     int              rotate;
     cairo_surface_t *surface;
+    cairo_surface_t *spread;
+    GdkPixmap       *pixmap;
   } PDF;
 
   struct
@@ -242,13 +597,15 @@ struct
     GStaticMutex pdflib_lock;
     GStaticMutex document_lock;
     GStaticMutex search_lock;
+    GStaticMutex cache_lock;
   } Lock;
 
   struct
   {
-    GThread* search_thread;
     gboolean search_thread_running;
-    GThread* inotify_thread;
+    int      load_id;
+    int      load_next;
+    guint    load_idle;
   } Thread;
 
   struct
@@ -267,20 +624,134 @@ void build_index(GtkTreeModel*, GtkTreeIter*, PopplerIndexIter*);
 void change_mode(int);
 void highlight_result(int, PopplerRectangle*);
 void draw(int);
+cairo_surface_t* render_page(PopplerPage*, int, int, GStaticMutex*, double*);
+void transform_page(cairo_t*, double, int, double, double);
+cairo_surface_t* render_tiled(int, int, int, double*);
+int tile_count();
+PopplerDocument* copy_document();
+gboolean copies_current();
+gboolean open_tiles();
+void free_tiles();
+void init_pool();
+cairo_surface_t* create_surface(cairo_format_t, int, int);
+void clear_pool();
+void init_scheduler();
+gboolean push_job(GThreadFunc, gpointer, int, GDestroyNotify, GCompareDataFunc);
+Job* next_job();
+void cancel_jobs(GThreadFunc, gboolean);
+void finish_jobs(GThreadFunc);
+void pause_jobs();
+void resume_jobs();
+gint compare_jobs(gconstpointer, gconstpointer, gpointer);
+void cancel_prefetch();
+void request_prefetch(int, int, int);
+void add_jump_target(int*, int*, int);
+void free_prefetch(gpointer);
+void free_argument(gpointer);
+void recolor_surface(cairo_surface_t*);
+void get_page_size(int, double*, double*);
+Raster* find_shared_raster(cairo_surface_t*, guint32, int);
+void get_view_size(int, double*, double*);
+void spread_pages(int, int*, int*);
+cairo_surface_t** page_surface(int);
+void render_spread(int, int);
+cairo_surface_t* get_raster(int, int);
+Raster* lookup_raster(int, int);
+Raster* find_raster(int);
+Raster* finish_raster(int, int, int, cairo_surface_t*);
+gboolean make_room(gsize, int);
+void free_raster(Raster*);
+void clear_rasters();
+Raster* store_raster(int, int, int, cairo_surface_t*);
+void pack_raster(Raster*);
+Raster* unpack_raster(int, int);
+void trim_packed(gsize);
+void free_packed(Packed*);
+void clear_packed();
+cairo_surface_t* get_recording(int, gboolean);
+cairo_surface_t* replay_page(PopplerPage*, cairo_surface_t*, int, int);
+void trim_recordings(gsize);
+void clear_recordings();
+gsize estimate_recording(int);
+char* document_identity(char*, time_t, off_t);
+char* disk_raster_path(int, int, int, const char*);
+guint32 raster_checksum(const guchar*, gsize);
+cairo_surface_t* map_disk_raster(char*, int*);
+cairo_surface_t* find_disk_raster(int, int, int, int*);
+Raster* load_disk_raster(int, int);
+void save_disk_raster(int, int, cairo_surface_t*);
+void trim_disk_cache(gsize);
+gint compare_disk_files(gconstpointer, gconstpointer);
+void detach_surface(int);
+void invalidate_pixmap();
+cairo_surface_t* gray_surface(cairo_surface_t*);
+void paint_surface(cairo_t*, cairo_surface_t*);
+void drop_rasters(int);
+void init_pressure();
+void shed_memory();
+gsize cgroup_memory_limit();
+Mapping* map_file(char*);
+Mapping* map_stream(int);
+void unmap_file(Mapping*);
 void eval_marker(int);
 void notify(int, char*);
 gboolean open_file(char*, char*);
+Page* load_page(int);
+void free_pages();
+void start_loader(char*, char*, int, gboolean);
+void parse_document(Loader*);
+void load_bookmarks(char*);
+void save_bookmarks();
+void clear_bookmarks();
+void load_costs(char*);
+void save_costs();
+void clear_costs();
+void record_cost(int, cairo_surface_t*, double);
+double predict_cost(int);
+void cache_document();
+gboolean take_cached_document(Loader*);
+void free_cached_document(CachedDocument*);
+int connect_server(char*);
+int send_to_server(char*, char*);
+void start_server();
+gboolean write_data(int, const char*, gsize);
+int listen_socket(char*);
+int run_daemon();
+RenderDocument* acquire_document(char*, PopplerDocument**);
+void release_document(RenderDocument*, PopplerDocument*);
+void free_render_document(RenderDocument*);
+gsize document_cost(RenderDocument*);
+gboolean reserve_memory(gsize);
+void release_memory(gsize);
+gboolean serve_request(int, char*);
+int run_batch(char*, char*, int, int, char*);
+int run_client(char*, char*, int, int, char*);
+int* parse_page_range(char*, int, int*);
 void open_uri(char*);
 void update_status();
 void recalcRectangle(int, PopplerRectangle*);
 void setCompletionRowColor(GtkBox*, int, int);
 void set_page(int);
 void switch_view(GtkWidget*);
+void open_overview();
+void free_overview();
+void layout_overview();
+void request_thumbnail(int);
+void trim_thumbnails(gsize);
+void free_thumbnail(gpointer);
+gint compare_thumbnails(gconstpointer, gconstpointer, gpointer);
 GtkEventBox* createCompletionRow(GtkBox*, char*, char*, gboolean);
 
 /* thread declaration */
 void* search(void*);
-void* watch_file(void*);
+void* load_document(void*);
+void serve_client(gpointer, gpointer);
+void* render_batch(void*);
+void* render_tile(void*);
+void* render_thumbnail(void*);
+void* write_disk_raster(void*);
+void* run_jobs(void*);
+void* prefetch_page(void*);
 
 /* shortcut declarations */
 void sc_abort(Argument*);
@@ -297,8 +768,11 @@ void sc_search(Argument*);
 void sc_switch_goto_mode(Argument*);
 void sc_navigate_index(Argument*);
 void sc_toggle_index(Argument*);
+void sc_toggle_overview(Argument*);
+void sc_navigate_overview(Argument*);
 void sc_toggle_inputbar(Argument*);
 void sc_toggle_statusbar(Argument*);
+void sc_toggle_presentation(Argument*);
 void sc_quit(Argument*);
 
 /* inputbar shortcut declarations */
@@ -309,14 +783,19 @@ void isc_string_manipulation(Argument*);
 
 /* command declarations */
 gboolean cmd_bookmark(int, char**);
+gboolean cmd_bench(int, char**);
+gboolean cmd_cache(int, char**);
 gboolean cmd_open_bookmark(int, char**);
 gboolean cmd_close(int, char**);
 gboolean cmd_correct_offset(int, char**);
 gboolean cmd_delete_bookmark(int, char**);
 gboolean cmd_export(int, char**);
+gboolean cmd_goto(int, char**);
 gboolean cmd_info(int, char**);
+gboolean cmd_jobs(int, char**);
 gboolean cmd_open(int, char**);
 gboolean cmd_print(int, char**);
+gboolean cmd_reload(int, char**);
 gboolean cmd_rotate(int, char**);
 gboolean cmd_set(int, char**);
 gboolean cmd_quit(int, char**);
@@ -341,13 +820,31 @@ gboolean scmd_search(char*, Argument*);
 
 /* callback declarations */
 gboolean cb_destroy(GtkWidget*, gpointer);
+gboolean cb_document_loaded(gpointer);
 gboolean cb_draw(GtkWidget*, GdkEventExpose*, gpointer);
 gboolean cb_index_row_activated(GtkTreeView*, GtkTreePath*, GtkTreeViewColumn*, gpointer);
 gboolean cb_inputbar_kb_pressed(GtkWidget*, GdkEventKey*, gpointer);
 gboolean cb_inputbar_activate(GtkEntry*, gpointer);
 gboolean cb_inputbar_form_activate(GtkEntry*, gpointer);
+gboolean cb_load_pages(gpointer);
+gboolean cb_overview_clicked(GtkWidget*, GdkEventButton*, gpointer);
+gboolean cb_overview_draw(GtkWidget*, GdkEventExpose*, gpointer);
+gboolean cb_prefetch(gpointer);
+gboolean cb_prefetched(gpointer);
+gboolean cb_prerender_jumps(gpointer);
+void cb_release_buffer(void*);
+gboolean cb_memory_pressure(GIOChannel*, GIOCondition, gpointer);
+gboolean cb_poll_pressure(gpointer);
+gboolean cb_pressure_relief(gpointer);
+gboolean cb_reload_file(gpointer);
+gboolean cb_server_accept(GIOChannel*, GIOCondition, gpointer);
+gboolean cb_server_read(GIOChannel*, GIOCondition, gpointer);
+cairo_status_t cb_write_png(void*, const unsigned char*, unsigned int);
+gboolean cb_stream_update(gpointer);
+gboolean cb_thumbnail_ready(gpointer);
 gboolean cb_view_kb_pressed(GtkWidget*, GdkEventKey*, gpointer);
 gboolean cb_view_resized(GtkWidget*, GtkAllocation*, gpointer);
+gboolean cb_watch_file(GIOChannel*, GIOCondition, gpointer);
 
 /* configuration */
 #include "config.h"
@@ -361,24 +858,53 @@ init_directories()
   g_mkdir_with_parents(base_directory,  0771);
   g_free(base_directory);
 
-  /* create or open existing bookmark file */
-  Zathura.Bookmarks.data = g_key_file_new();
-  char* bookmarks = g_strdup_printf("%s/%s/%s", g_get_home_dir(), ZATHURA_DIR, BOOKMARK_FILE);
+  /* create the directory of rendered pages */
+  Zathura.Disk.directory = g_build_filename(g_get_home_dir(), ZATHURA_DIR, DISK_CACHE_DIR, NULL);
+  g_mkdir_with_parents(Zathura.Disk.directory, 0700);
 
-  if(!g_file_test(bookmarks, G_FILE_TEST_IS_REGULAR))
-  {
-    /* file does not exist */
-    g_file_set_contents(bookmarks, "# Zathura bookmarks\n", -1, NULL);
-  }
+  /* create bookmark directory, every document gets its own journal */
+  Zathura.Bookmarks.directory = g_build_filename(g_get_home_dir(), ZATHURA_DIR, BOOKMARK_DIR, NULL);
 
-  GError* error = NULL;
-  if(!g_key_file_load_from_file(Zathura.Bookmarks.data, bookmarks, 
-        G_KEY_FILE_KEEP_COMMENTS | G_KEY_FILE_KEEP_TRANSLATIONS, &error))
+  if(g_file_test(Zathura.Bookmarks.directory, G_FILE_TEST_IS_DIR))
+    return;
+
+  g_mkdir_with_parents(Zathura.Bookmarks.directory, 0771);
+
+  /* move the entries of an old bookmark file into journals once */
+  char* bookmarks     = g_build_filename(g_get_home_dir(), ZATHURA_DIR, BOOKMARK_FILE, NULL);
+  GKeyFile* key_file  = g_key_file_new();
+
+  if(g_key_file_load_from_file(key_file, bookmarks, G_KEY_FILE_NONE, NULL))
   {
-    notify(ERROR, g_strdup_printf("Could not load bookmark file: %s", error->message));
+    gsize i, j;
+    gsize number_of_groups = 0;
+    char** groups          = g_key_file_get_groups(key_file, &number_of_groups);
+
+    for(i = 0; i < number_of_groups; i++)
+    {
+      gsize number_of_keys = 0;
+      char** keys          = g_key_file_get_keys(key_file, groups[i], &number_of_keys, NULL);
+      GString* journal     = g_string_new("");
+
+      g_string_append_printf(journal, "# %s\n", groups[i]);
+      for(j = 0; j < number_of_keys; j++)
+        g_string_append_printf(journal, "%d %s\n",
+            g_key_file_get_integer(key_file, groups[i], keys[j], NULL), keys[j]);
+
+      char* checksum = g_compute_checksum_for_string(G_CHECKSUM_SHA1, groups[i], -1);
+      char* file     = g_build_filename(Zathura.Bookmarks.directory, checksum, NULL);
+      g_file_set_contents(file, journal->str, journal->len, NULL);
+
+      g_free(file);
+      g_free(checksum);
+      g_string_free(journal, TRUE);
+      g_strfreev(keys);
+    }
+
+    g_strfreev(groups);
   }
 
-  Zathura.Bookmarks.file = g_strdup(bookmarks);
+  g_key_file_free(key_file);
   g_free(bookmarks);
 }
 
@@ -389,6 +915,7 @@ init_zathura()
   g_static_mutex_init(&(Zathura.Lock.pdflib_lock));
   g_static_mutex_init(&(Zathura.Lock.search_lock));
   g_static_mutex_init(&(Zathura.Lock.document_lock));
+  g_static_mutex_init(&(Zathura.Lock.cache_lock));
 
   /* look */
   gdk_color_parse(default_fgcolor,        &(Zathura.Style.default_fg));
@@ -416,18 +943,88 @@ init_zathura()
   Zathura.Global.mode          = NORMAL;
   Zathura.Global.viewing_mode  = NORMAL;
   Zathura.Global.recolor       = RECOLOR_OPEN;
+  Zathura.Global.stream        = STREAM_OPEN;
+  Zathura.Global.spread        = SPREAD_OPEN;
+  Zathura.Global.spread_cover  = SPREAD_COVER;
   Zathura.Global.adjust_mode   = ADJUST_OPEN;
   Zathura.Global.goto_mode     = GOTO_MODE;
+  Zathura.Global.tiles         = TILES;
 
   Zathura.State.filename          = (char*) DEFAULT_TEXT;
   Zathura.State.pages             = "";
   Zathura.State.scroll_percentage = 0;
+  Zathura.State.goto_page         = -1;
+
+  Zathura.Stream.file     = NULL;
+  Zathura.Stream.password = NULL;
+  Zathura.Stream.size     = 0;
+  Zathura.Stream.parsing  = FALSE;
+  Zathura.Stream.update   = 0;
 
   Zathura.Marker.markers           = NULL;
   Zathura.Marker.number_of_markers =  0;
   Zathura.Marker.last              = -1;
 
-  Zathura.Inotify.fd = inotify_init();
+  /* inotify */
+  Zathura.Inotify.wd      = -1;
+  Zathura.Inotify.watch   = 0;
+  Zathura.Inotify.reload  = 0;
+  Zathura.Inotify.channel = NULL;
+  Zathura.Inotify.fd      = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+  if(Zathura.Inotify.fd != -1)
+  {
+    Zathura.Inotify.channel = g_io_channel_unix_new(Zathura.Inotify.fd);
+    Zathura.Inotify.watch   = g_io_add_watch(Zathura.Inotify.channel, G_IO_IN, cb_watch_file, NULL);
+  }
+
+  /* server */
+  Zathura.Server.socket  = g_build_filename(g_get_user_runtime_dir(), SERVER_SOCKET, NULL);
+  Zathura.Server.fd      = -1;
+  Zathura.Server.channel = NULL;
+  Zathura.Server.watch   = 0;
+
+  Zathura.Cache.documents = NULL;
+  Zathura.Cache.rasters   = NULL;
+  Zathura.Cache.used      = 0;
+  Zathura.Cache.size      = CACHE_SIZE;
+  Zathura.Cache.clock     = 0;
+  Zathura.Cache.prefetch  = 0;
+  Zathura.Cache.jumps     = 0;
+  Zathura.Cache.packed        = NULL;
+  Zathura.Cache.packed_used   = 0;
+  Zathura.Cache.packed_size   = PACKED_SIZE;
+  Zathura.Cache.hits          = 0;
+  Zathura.Cache.packed_hits   = 0;
+  Zathura.Cache.packed_misses = 0;
+  Zathura.Cache.shared        = 0;
+  Zathura.Cache.recordings      = NULL;
+  Zathura.Cache.recordings_used = 0;
+  Zathura.Cache.recording_size  = RECORDING_SIZE;
+  Zathura.Cache.rendered        = g_hash_table_new(g_direct_hash, g_direct_equal);
+  Zathura.Cache.prefetching     = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+  /* rendered pages on disk */
+  Zathura.Disk.document = NULL;
+  Zathura.Disk.size     = DISK_CACHE_SIZE;
+  Zathura.Disk.used     = 0;
+  Zathura.Disk.counted  = FALSE;
+  Zathura.Disk.hits     = 0;
+  g_static_mutex_init(&(Zathura.Disk.lock));
+
+  /* background jobs */
+  init_scheduler();
+
+  /* render costs */
+  Zathura.Costs.pages     = g_hash_table_new(g_direct_hash, g_direct_equal);
+  Zathura.Costs.file      = NULL;
+  Zathura.Costs.changed   = FALSE;
+  Zathura.Costs.timer     = g_timer_new();
+  Zathura.Costs.last_page = -1;
+  Zathura.Costs.interval  = READING_TIME / 1000.0;
+
+  /* memory pressure */
+  init_pressure();
 
   /* UI */
   Zathura.UI.window            = GTK_WINDOW(gtk_window_new(GTK_WINDOW_TOPLEVEL));
@@ -436,6 +1033,7 @@ init_zathura()
   Zathura.UI.view              = GTK_SCROLLED_WINDOW(gtk_scrolled_window_new(NULL, NULL));
   Zathura.UI.viewport          = GTK_VIEWPORT(gtk_viewport_new(NULL, NULL));
   Zathura.UI.drawing_area      = gtk_drawing_area_new();
+  Zathura.UI.overview          = gtk_drawing_area_new();
   Zathura.UI.statusbar         = gtk_event_box_new();
   Zathura.UI.statusbar_entries = GTK_BOX(gtk_hbox_new(FALSE, 0));
   Zathura.UI.inputbar          = GTK_ENTRY(gtk_entry_new());
@@ -471,6 +1069,22 @@ init_zathura()
   gtk_widget_show(Zathura.UI.drawing_area);
   g_signal_connect(G_OBJECT(Zathura.UI.drawing_area), "expose-event", G_CALLBACK(cb_draw), NULL);
 
+  /* overview */
+  gtk_widget_modify_bg(GTK_WIDGET(Zathura.UI.overview), GTK_STATE_NORMAL, &(Zathura.Style.default_bg));
+  gtk_widget_add_events(GTK_WIDGET(Zathura.UI.overview), GDK_BUTTON_PRESS_MASK);
+  gtk_widget_show(Zathura.UI.overview);
+  g_signal_connect(G_OBJECT(Zathura.UI.overview), "expose-event",       G_CALLBACK(cb_overview_draw),    NULL);
+  g_signal_connect(G_OBJECT(Zathura.UI.overview), "button-press-event", G_CALLBACK(cb_overview_clicked), NULL);
+
+  Zathura.Overview.documents  = NULL;
+  Zathura.Overview.thumbnails = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, free_thumbnail);
+  Zathura.Overview.queued     = g_hash_table_new(g_direct_hash, g_direct_equal);
+  Zathura.Overview.used       = 0;
+  Zathura.Overview.clock      = 0;
+  Zathura.Overview.generation = 0;
+  Zathura.Overview.columns    = 1;
+  Zathura.Overview.visible    = FALSE;
+
   /* statusbar */
   gtk_widget_modify_bg(GTK_WIDGET(Zathura.UI.statusbar), GTK_STATE_NORMAL, &(Zathura.Style.statusbar_bg));
 
@@ -586,48 +1200,57 @@ build_index(GtkTreeModel* model, GtkTreeIter* parent, PopplerIndexIter* index_it
 void
 draw(int page_id)
 {
-  if(!Zathura.PDF.document || page_id < 0 || page_id > Zathura.PDF.number_of_pages)
+  if(!Zathura.PDF.document || page_id < 0 || page_id >= Zathura.PDF.number_of_pages
+      || !Zathura.PDF.pages[page_id])
     return;
 
-  double page_width, page_height;
-  double width, height;
+  if(Zathura.PDF.surface)
+    cairo_surface_destroy(Zathura.PDF.surface);
+  if(Zathura.PDF.spread)
+    cairo_surface_destroy(Zathura.PDF.spread);
+  Zathura.PDF.spread = NULL;
+  invalidate_pixmap();
 
-  double scale = ((double) Zathura.PDF.scale / 100.0);
+  /* page faults per page turn show how well the buffers are reused */
+  struct rusage before, after;
+  getrusage(RUSAGE_SELF, &before);
 
-  int rotate = Zathura.PDF.rotate;
+  /* no other job is started while the visible page is rendered */
+  pause_jobs();
 
-  Page *current_page = Zathura.PDF.pages[page_id];
+  int left, right;
+  spread_pages(page_id, &left, &right);
 
-  if(Zathura.PDF.surface)
-    cairo_surface_destroy(Zathura.PDF.surface);
-  Zathura.PDF.surface = NULL;
+  if(right != -1)
+    render_spread(left, right);
+  else
+    Zathura.PDF.surface = get_raster(page_id, PRIORITY_VISIBLE);
 
-  g_static_mutex_lock(&(Zathura.Lock.pdflib_lock));
-  poppler_page_get_size(current_page->page, &page_width, &page_height);
-  g_static_mutex_unlock(&(Zathura.Lock.pdflib_lock));
+  resume_jobs();
 
-  if(rotate == 0 || rotate == 180)
-  {
-    width  = page_width  * scale;
-    height = page_height * scale;
-  }
-  else
-  {
-    width  = page_height * scale;
-    height = page_width  * scale;
-  }
+  getrusage(RUSAGE_SELF, &after);
+  Zathura.Pool.faults += after.ru_minflt - before.ru_minflt;
+  Zathura.Pool.turns++;
 
-  cairo_t *cairo;
-  Zathura.PDF.surface = cairo_image_surface_create(CAIRO_FORMAT_RGB24, width, height);
-  cairo = cairo_create(Zathura.PDF.surface);
+  double width, height;
+  get_view_size(page_id, &width, &height);
 
-  cairo_save(cairo);
-  cairo_set_source_rgb(cairo, 1, 1, 1);
-  cairo_rectangle(cairo, 0, 0, width, height);
-  cairo_fill(cairo);
-  cairo_restore(cairo);
-  cairo_save(cairo);
+  gtk_widget_set_size_request(Zathura.UI.drawing_area, width, height);
+  gtk_widget_queue_draw(Zathura.UI.drawing_area);
 
+  /* render the next page while the user is reading */
+  if(!Zathura.Cache.prefetch)
+    Zathura.Cache.prefetch = gdk_threads_add_idle(cb_prefetch, NULL);
+
+  /* and the pages a jump would lead to once the user stays on this one */
+  if(Zathura.Cache.jumps)
+    g_source_remove(Zathura.Cache.jumps);
+  Zathura.Cache.jumps = gdk_threads_add_timeout(JUMP_DELAY, cb_prerender_jumps, NULL);
+}
+
+void
+transform_page(cairo_t* cairo, double scale, int rotate, double width, double height)
+{
   switch(rotate)
   {
     case 90:
@@ -648,2555 +1271,7267 @@ draw(int page_id)
 
   if(rotate != 0)
     cairo_rotate(cairo, rotate * G_PI / 180.0);
+}
 
-  g_static_mutex_lock(&(Zathura.Lock.pdflib_lock));
-  poppler_page_render(current_page->page, cairo);
-  g_static_mutex_unlock(&(Zathura.Lock.pdflib_lock));
+cairo_surface_t*
+render_tiled(int page_id, int scale_level, int rotate, double* time)
+{
+  if(!open_tiles())
+    return NULL;
 
-  cairo_restore(cairo);
-  cairo_destroy(cairo);
+  double width, height;
+  get_page_size(page_id, &width, &height);
 
-  if(Zathura.Global.recolor)
-  {
-    unsigned char* image = cairo_image_surface_get_data(Zathura.PDF.surface);
-    int x, y;
+  /* a page less than a row high is not split, render_page takes it */
+  if((int) height < 1)
+    return NULL;
 
-    int width     = cairo_image_surface_get_width(Zathura.PDF.surface);
-    int height    = cairo_image_surface_get_height(Zathura.PDF.surface);
-    int rowstride = cairo_image_surface_get_stride(Zathura.PDF.surface);
+  int count       = MIN(Zathura.Tiles.count, (int) height);
+  int tile_height = ((int) height + count - 1) / count;
 
-    /* recolor code based on qimageblitz library flatten() function
-    (http://sourceforge.net/projects/qimageblitz/) */
+  cairo_surface_t* surface = create_surface(CAIRO_FORMAT_RGB24, width, height);
+  unsigned char* image     = cairo_image_surface_get_data(surface);
+  int rowstride            = cairo_image_surface_get_stride(surface);
 
-    int r1 = Zathura.Style.recolor_darkcolor.red    / 257;
-    int g1 = Zathura.Style.recolor_darkcolor.green  / 257;
-    int b1 = Zathura.Style.recolor_darkcolor.blue   / 257;
-    int r2 = Zathura.Style.recolor_lightcolor.red   / 257;
-    int g2 = Zathura.Style.recolor_lightcolor.green / 257;
-    int b2 = Zathura.Style.recolor_lightcolor.blue  / 257;
+  Tile* tiles       = malloc(count * sizeof(Tile));
+  GThread** workers = malloc(count * sizeof(GThread*));
 
-    int min = 0x00;
-    int max = 0xFF;
-    int mean;
+  /* the tiles are bands of rows that share the memory of the raster */
+  int i;
+  for(i = 0; i < count; i++)
+  {
+    tiles[i].document = Zathura.Tiles.documents[i];
+    tiles[i].page     = page_id;
+    tiles[i].scale    = scale_level;
+    tiles[i].rotate   = rotate;
+    tiles[i].width    = width;
+    tiles[i].height   = height;
+    tiles[i].y        = i * tile_height;
+    tiles[i].surface  = cairo_image_surface_create_for_data(image + tiles[i].y * rowstride, CAIRO_FORMAT_RGB24,
+        width, MAX(MIN(tile_height, (int) height - tiles[i].y), 0), rowstride);
+
+    workers[i] = g_thread_create(render_tile, &tiles[i], TRUE, NULL);
+  }
 
-    float sr = ((float) r2 - r1) / (max - min);
-    float sg = ((float) g2 - g1) / (max - min);
-    float sb = ((float) b2 - b1) / (max - min);
+  /* the bands count as if they had been rendered one after another */
+  *time = 0;
 
-    for (y = 0; y < height; y++) 
-    {
-      unsigned char* data = image + y * rowstride;
+  for(i = 0; i < count; i++)
+  {
+    if(workers[i])
+      g_thread_join(workers[i]);
+    else
+      render_tile(&tiles[i]);
 
-      for (x = 0; x < width; x++) 
-      {
-        mean = (data[0] + data[1] + data[2]) / 3;
-        data[2] = sr * (mean - min) + r1 + 0.5;
-        data[1] = sg * (mean - min) + g1 + 0.5;
-        data[0] = sb * (mean - min) + b1 + 0.5;
-        data += 4;
-      }
-    }
+    *time += tiles[i].time;
+    cairo_surface_destroy(tiles[i].surface);
   }
 
-  gtk_widget_set_size_request(Zathura.UI.drawing_area, width, height);
-  gtk_widget_queue_draw(Zathura.UI.drawing_area);
+  free(workers);
+  free(tiles);
+
+  cairo_surface_mark_dirty(surface);
+
+  return surface;
 }
 
-void
-change_mode(int mode)
+int
+tile_count()
 {
-  char* mode_text;
+  /* every band costs a parsed document and a thread, more bands than
+   * processors only add to that */
+  long processors = MAX(sysconf(_SC_NPROCESSORS_ONLN), 1);
 
-  switch(mode)
-  {
-    case INSERT:
-      mode_text = "-- INSERT --";
-      break;
-    case VISUAL:
-      mode_text = "-- VISUAL --";
-      break;
-    case ADD_MARKER:
-      mode_text = "";
-      break;
-    case EVAL_MARKER:
-      mode_text = "";
-      break;
-    default:
-      mode_text = "";
-      mode      = NORMAL;
-      break;
-  }
+  if(Zathura.Global.tiles <= 0)
+    return processors;
 
-  Zathura.Global.mode = mode;
-  notify(DEFAULT, mode_text);
+  return MIN(Zathura.Global.tiles, processors);
 }
 
-void
-eval_marker(int id)
+PopplerDocument*
+copy_document()
 {
-  /* go to last marker */
-  if(id == 0x27)
+  char* password = (Zathura.PDF.password && strlen(Zathura.PDF.password) != 0) ? Zathura.PDF.password : NULL;
+
+  /* documents read into memory are parsed from there, files that are
+   * not mapped are opened again */
+  if(Zathura.PDF.mapping)
+    return poppler_document_new_from_data(Zathura.PDF.mapping->data, Zathura.PDF.mapping->length,
+        password, NULL);
+
+  if(!Zathura.PDF.file || !copies_current())
+    return NULL;
+
+  PopplerDocument* document = NULL;
+  char* file_uri = g_filename_to_uri(Zathura.PDF.file, NULL, NULL);
+  if(file_uri)
+    document = poppler_document_new_from_file(file_uri, password, NULL);
+  g_free(file_uri);
+
+  return document;
+}
+
+gboolean
+copies_current()
+{
+  if(Zathura.PDF.mapping)
+    return TRUE;
+
+  /* copies opened from the file again must find the same bytes the shown
+   * document was parsed from, a file that is still being written never does */
+  struct stat information;
+  return Zathura.PDF.mtime && stat(Zathura.PDF.file, &information) == 0 &&
+    information.st_mtime == Zathura.PDF.mtime && information.st_size == Zathura.PDF.file_size;
+}
+
+gboolean
+open_tiles()
+{
+  /* the copies go as soon as the file has changed, until it is reloaded
+   * the pages are rendered from the shown document */
+  if(!copies_current())
   {
-    int current_page = Zathura.PDF.page_number;
-    set_page(Zathura.Marker.last);
-    Zathura.Marker.last = current_page;
-    return;
+    free_tiles();
+    return FALSE;
   }
 
-  /* search markers */
+  /* every tile is rendered by a document of its own */
+  int count = tile_count();
+  if(Zathura.Tiles.count != count)
+    free_tiles();
+
+  if(Zathura.Tiles.documents)
+    return TRUE;
+
+  Zathura.Tiles.documents = calloc(count, sizeof(PopplerDocument*));
+  Zathura.Tiles.count     = count;
+
   int i;
-  for(i = 0; i < Zathura.Marker.number_of_markers; i++)
+  for(i = 0; i < Zathura.Tiles.count; i++)
   {
-    if(Zathura.Marker.markers[i].id == id)
+    Zathura.Tiles.documents[i] = copy_document();
+
+    if(!Zathura.Tiles.documents[i])
     {
-      set_page(Zathura.Marker.markers[i].page);
-      return;
+      free_tiles();
+      return FALSE;
     }
   }
+
+  return TRUE;
 }
 
 void
-highlight_result(int page_id, PopplerRectangle* rectangle)
+free_tiles()
 {
-  cairo_t *cairo = cairo_create(Zathura.PDF.surface);
-  cairo_set_source_rgba(cairo, Zathura.Style.search_highlight.red, Zathura.Style.search_highlight.green,
-      Zathura.Style.search_highlight.blue, TRANSPARENCY);
+  int i;
+  for(i = 0; i < Zathura.Tiles.count; i++)
+  {
+    if(Zathura.Tiles.documents[i])
+      g_object_unref(Zathura.Tiles.documents[i]);
+  }
 
-  recalcRectangle(page_id, rectangle);
-  cairo_rectangle(cairo, rectangle->x1, rectangle->y1, (rectangle->x2 - rectangle->x1), (rectangle->y2 - rectangle->y1));
-  cairo_fill(cairo);
+  free(Zathura.Tiles.documents);
+  Zathura.Tiles.documents = NULL;
+  Zathura.Tiles.count     = 0;
+
+  if(Zathura.Tiles.spread)
+    g_object_unref(Zathura.Tiles.spread);
+  Zathura.Tiles.spread = NULL;
 }
 
-void notify(int level, char* message)
+void
+init_pool()
 {
-  switch(level)
+  Zathura.Pool.buffers = NULL;
+  Zathura.Pool.size    = 0;
+  Zathura.Pool.faults  = 0;
+  Zathura.Pool.turns   = 0;
+
+  g_static_mutex_init(&(Zathura.Pool.lock));
+}
+
+cairo_surface_t*
+create_surface(cairo_format_t format, int width, int height)
+{
+  int rowstride = cairo_format_stride_for_width(format, width);
+  Buffer* buffer = NULL;
+
+  /* surfaces are destroyed by the rendering threads as well */
+  g_static_mutex_lock(&(Zathura.Pool.lock));
+
+  GList* list;
+  for(list = Zathura.Pool.buffers; list; list = g_list_next(list))
   {
-    case ERROR:
-      gtk_widget_modify_base(GTK_WIDGET(Zathura.UI.inputbar), GTK_STATE_NORMAL, &(Zathura.Style.notification_e_bg));
-      gtk_widget_modify_text(GTK_WIDGET(Zathura.UI.inputbar), GTK_STATE_NORMAL, &(Zathura.Style.notification_e_fg));
-      break;
-    case WARNING:
-      gtk_widget_modify_base(GTK_WIDGET(Zathura.UI.inputbar), GTK_STATE_NORMAL, &(Zathura.Style.notification_w_bg));
-      gtk_widget_modify_text(GTK_WIDGET(Zathura.UI.inputbar), GTK_STATE_NORMAL, &(Zathura.Style.notification_w_fg));
-      break;
-    default:
-      gtk_widget_modify_base(GTK_WIDGET(Zathura.UI.inputbar), GTK_STATE_NORMAL, &(Zathura.Style.inputbar_bg));
-      gtk_widget_modify_text(GTK_WIDGET(Zathura.UI.inputbar), GTK_STATE_NORMAL, &(Zathura.Style.inputbar_fg));
+    Buffer* candidate = (Buffer*) list->data;
+    if(candidate->format == format && candidate->width == width && candidate->height == height)
+    {
+      buffer = candidate;
+      Zathura.Pool.buffers = g_list_delete_link(Zathura.Pool.buffers, list);
+      Zathura.Pool.size   -= buffer->size;
       break;
+    }
   }
- 
-  if(message)
-    gtk_entry_set_text(Zathura.UI.inputbar, message);
-}
 
-gboolean
-open_file(char* path, char* password)
-{
-  /* get filename */
-  char* file = realpath(path, NULL);
+  g_static_mutex_unlock(&(Zathura.Pool.lock));
 
-  if(path[0] == '~')
+  if(!buffer)
   {
-    char* home_path = getenv("HOME");
-    int file_len = strlen(home_path) + strlen(path) - 1;
-    file = malloc(file_len);
-    snprintf(file, file_len, "%s%s", getenv("HOME"), path + 1);
-  }
+    buffer         = malloc(sizeof(Buffer));
+    buffer->format = format;
+    buffer->width  = width;
+    buffer->height = height;
+    buffer->size   = (gsize) rowstride * height;
+
+    /* large rasters are backed by huge pages where the kernel allows it */
+    void* data = NULL;
+    if(buffer->size >= HUGE_PAGE_SIZE && !posix_memalign(&data, HUGE_PAGE_SIZE, buffer->size))
+    {
+#ifdef MADV_HUGEPAGE
+      madvise(data, buffer->size, MADV_HUGEPAGE);
+#endif
+    }
+    else if(posix_memalign(&data, 64, MAX(buffer->size, 1)))
+      data = NULL;
 
-  /* check if file exists */
-  if(!g_file_test(file, G_FILE_TEST_IS_REGULAR))
-  {
-    notify(ERROR, "File does not exist");
-    free(file);
-    return FALSE;
-  }
+    if(!data)
+    {
+      free(buffer);
+      return cairo_image_surface_create(format, width, height);
+    }
 
-  /* close old file */
-  cmd_close(-1, NULL);
+    buffer->data = data;
+  }
 
-  /* check saved password */
-  if(!password)
-    password = (Zathura.PDF.password && strlen(Zathura.PDF.password) != 0) ? Zathura.PDF.password : NULL;
+  cairo_surface_t* surface = cairo_image_surface_create_for_data(buffer->data, format, width, height, rowstride);
+  cairo_surface_set_user_data(surface, &(Zathura.Pool.key), buffer, cb_release_buffer);
 
-  /* format path */
-  GError* error = NULL;
-  char* file_uri = g_filename_to_uri(file, NULL, &error);
-  if (!file_uri)
-  {
-    char* message = g_strdup_printf("Can not open file: %s", error->message);
-    notify(ERROR, message);
-    g_free(message);
-    g_error_free(error);
-    return FALSE;
-  }
+  return surface;
+}
 
-  /* open file */
-  g_static_mutex_lock(&(Zathura.Lock.pdflib_lock));
-  g_static_mutex_lock(&(Zathura.Lock.document_lock));
-  Zathura.PDF.document = poppler_document_new_from_file(file_uri, password ? password : NULL, &error);
-  g_static_mutex_unlock(&(Zathura.Lock.document_lock));
-  g_static_mutex_unlock(&(Zathura.Lock.pdflib_lock));
-  g_free(file_uri);
+void
+clear_pool()
+{
+  g_static_mutex_lock(&(Zathura.Pool.lock));
 
-  if(!Zathura.PDF.document)
+  GList* list;
+  for(list = Zathura.Pool.buffers; list; list = g_list_next(list))
   {
-    char* message = (error->code == 1) ? "(Use \":set password\" to set the password)" : "";
-    message = g_strdup_printf("Can not open file: %s %s", error->message, message);
-    notify(ERROR, message);
-    g_free(message);
-    g_error_free(error);
-    return FALSE;
+    Buffer* buffer = (Buffer*) list->data;
+    free(buffer->data);
+    free(buffer);
   }
 
-  /* inotify */
-  if(Zathura.Inotify.fd != -1)
-  {
-    if((Zathura.Inotify.wd = inotify_add_watch(Zathura.Inotify.fd, file, IN_CLOSE_WRITE)) != -1)
-      Zathura.Thread.inotify_thread = g_thread_create(watch_file, NULL, TRUE, NULL);
-  }
+  g_list_free(Zathura.Pool.buffers);
+  Zathura.Pool.buffers = NULL;
+  Zathura.Pool.size    = 0;
 
-  g_static_mutex_lock(&(Zathura.Lock.pdflib_lock));
-  Zathura.PDF.number_of_pages = poppler_document_get_n_pages(Zathura.PDF.document);
-  g_static_mutex_unlock(&(Zathura.Lock.pdflib_lock));
-  Zathura.PDF.file            = file;
-  Zathura.PDF.scale           = 100;
-  Zathura.PDF.rotate          = 0;
-  Zathura.PDF.pages           = malloc(Zathura.PDF.number_of_pages * sizeof(Page*));
-  Zathura.State.filename      = g_markup_escape_text(file, -1);
+  g_static_mutex_unlock(&(Zathura.Pool.lock));
+}
 
-  /* get pages and check label mode */
-  g_static_mutex_lock(&(Zathura.Lock.pdflib_lock));
-  Zathura.Global.enable_labelmode = FALSE;
+void
+init_scheduler()
+{
+  Zathura.Scheduler.lock     = g_mutex_new();
+  Zathura.Scheduler.wake     = g_cond_new();
+  Zathura.Scheduler.finished = g_cond_new();
+  Zathura.Scheduler.running  = NULL;
+  Zathura.Scheduler.visible  = 0;
 
   int i;
-  for(i = 0; i < Zathura.PDF.number_of_pages; i++)
+  for(i = 0; i < JOB_CLASSES; i++)
   {
-    Zathura.PDF.pages[i] = malloc(sizeof(Page));
-    Zathura.PDF.pages[i]->id = i + 1;
-    Zathura.PDF.pages[i]->page = poppler_document_get_page(Zathura.PDF.document, i);
-    g_object_get(G_OBJECT(Zathura.PDF.pages[i]->page), "label", &(Zathura.PDF.pages[i]->label), NULL);
-
-    /* check if it is necessary to use the label mode */
-    int label_int = atoi(Zathura.PDF.pages[i]->label);
-    if(label_int == 0 || label_int != (i+1))
-      Zathura.Global.enable_labelmode = TRUE;
+    Zathura.Scheduler.queues[i]  = g_queue_new();
+    Zathura.Scheduler.skipped[i] = 0;
+    Zathura.Scheduler.done[i]    = 0;
   }
-  g_static_mutex_unlock(&(Zathura.Lock.pdflib_lock));
-
-  /* set correct goto mode */
-  if(!Zathura.Global.enable_labelmode && GOTO_MODE == GOTO_LABELS)
-    Zathura.Global.goto_mode = GOTO_DEFAULT;
 
-  /* start page */
-  int start_page          = 0;
-  Zathura.PDF.page_offset = 0;
+  Zathura.Scheduler.workers = malloc(sizeof(GThread*) * MAX(SCHEDULER_WORKERS, 1));
+  Zathura.Scheduler.count   = 0;
 
-  /* bookmarks */
-  if(Zathura.Bookmarks.data && g_key_file_has_group(Zathura.Bookmarks.data, file))
+  for(i = 0; i < SCHEDULER_WORKERS; i++)
   {
-    /* get last opened page */
-    if(g_key_file_has_key(Zathura.Bookmarks.data, file, BM_PAGE_ENTRY, NULL))
-      start_page = g_key_file_get_integer(Zathura.Bookmarks.data, file, BM_PAGE_ENTRY, NULL);
-
-    /* get page offset */
-    if(g_key_file_has_key(Zathura.Bookmarks.data, file, BM_PAGE_OFFSET, NULL))
-      Zathura.PDF.page_offset = g_key_file_get_integer(Zathura.Bookmarks.data, file, BM_PAGE_OFFSET, NULL);
-    if((Zathura.PDF.page_offset != 0) && (Zathura.PDF.page_offset != GOTO_OFFSET))
-      Zathura.PDF.page_offset = GOTO_OFFSET;
+    GThread* worker = g_thread_create(run_jobs, NULL, TRUE, NULL);
+    if(worker)
+      Zathura.Scheduler.workers[Zathura.Scheduler.count++] = worker;
+  }
+}
 
-    /* open and read bookmark file */
-    gsize i              = 0;
-    gsize number_of_keys = 0;
-    char** keys          = g_key_file_get_keys(Zathura.Bookmarks.data, file, &number_of_keys, NULL);
+gboolean
+push_job(GThreadFunc function, gpointer data, int priority, GDestroyNotify destroy, GCompareDataFunc compare)
+{
+  /* the caller runs the job itself if there are no workers */
+  if(!Zathura.Scheduler.count)
+    return FALSE;
 
-    for(i = 0; i < number_of_keys; i++)
-    {
-      if(strcmp(keys[i], BM_PAGE_ENTRY) && strcmp(keys[i], BM_PAGE_OFFSET))
-      {
-        Zathura.Bookmarks.bookmarks = realloc(Zathura.Bookmarks.bookmarks, 
-            (Zathura.Bookmarks.number_of_bookmarks + 1) * sizeof(Bookmark)); 
+  Job* job      = malloc(sizeof(Job));
+  job->function = function;
+  job->data     = data;
+  job->destroy  = destroy;
+  job->compare  = compare;
+  job->priority = priority;
 
-        Zathura.Bookmarks.bookmarks[Zathura.Bookmarks.number_of_bookmarks].id   = keys[i];
-        Zathura.Bookmarks.bookmarks[Zathura.Bookmarks.number_of_bookmarks].page = 
-          g_key_file_get_integer(Zathura.Bookmarks.data, file, keys[i], NULL);
+  g_mutex_lock(Zathura.Scheduler.lock);
 
-        Zathura.Bookmarks.number_of_bookmarks++;
-      }
-    }
-  }
+  GQueue* queue = Zathura.Scheduler.queues[priority - PRIORITY_VISIBLE];
+  if(compare)
+    g_queue_insert_sorted(queue, job, compare_jobs, NULL);
+  else
+    g_queue_push_tail(queue, job);
 
-  /* show document */
-  set_page(start_page);
-  update_status();
+  g_cond_signal(Zathura.Scheduler.wake);
+  g_mutex_unlock(Zathura.Scheduler.lock);
 
   return TRUE;
 }
 
-void open_uri(char* uri)
+Job*
+next_job()
 {
-  char* uri_cmd = g_strdup_printf(URI_COMMAND, uri);
-  system(uri_cmd);
-  g_free(uri_cmd);
-}
+  GQueue** queues = Zathura.Scheduler.queues;
+  int* skipped    = Zathura.Scheduler.skipped;
 
-void
-update_status()
-{
-  /* update text */
-  gtk_label_set_markup((GtkLabel*) Zathura.Global.status_text, Zathura.State.filename);
+  /* visible work always goes first, and nothing else is started while a
+   * visible page is rendered */
+  if(!g_queue_is_empty(queues[0]))
+    return g_queue_pop_head(queues[0]);
 
-  /* update pages */
-  if( Zathura.PDF.document && Zathura.PDF.pages )
+  if(Zathura.Scheduler.visible > 0)
+    return NULL;
+
+  /* a class that has been passed over too often goes ahead once, so that
+   * background work keeps moving while pages are prefetched */
+  int chosen = -1;
+  int i;
+  for(i = 1; i < JOB_CLASSES && chosen == -1; i++)
   {
-    int page = Zathura.PDF.page_number;
-    /*
-    if((Zathura.Global.goto_mode == GOTO_LABELS) && Zathura.PDF.pages[page]->label)
-      Zathura.State.pages = g_strdup_printf("[%s/%i]", 
-          Zathura.PDF.pages[page]->label, Zathura.PDF.number_of_pages);
-    else
-    */
-      Zathura.State.pages = g_strdup_printf("[%i/%i]", page + 1, Zathura.PDF.number_of_pages);
+    if(!g_queue_is_empty(queues[i]) && skipped[i] >= SCHEDULER_AGING)
+      chosen = i;
   }
 
-  /* update state */
-  char* zoom_level  = (Zathura.PDF.scale != 0) ? g_strdup_printf("%d%%", Zathura.PDF.scale) : "";
-  char* goto_mode   = (Zathura.Global.goto_mode == GOTO_LABELS) ? "L" : 
-    (Zathura.Global.goto_mode == GOTO_OFFSET) ? "O" : "D";
-  char* status_text = g_strdup_printf("%s [%s] %s", zoom_level, goto_mode, Zathura.State.pages);
-  gtk_label_set_markup((GtkLabel*) Zathura.Global.status_state, status_text);
+  for(i = 1; i < JOB_CLASSES && chosen == -1; i++)
+  {
+    if(!g_queue_is_empty(queues[i]))
+      chosen = i;
+  }
+
+  if(chosen == -1)
+    return NULL;
+
+  for(i = chosen + 1; i < JOB_CLASSES; i++)
+  {
+    if(!g_queue_is_empty(queues[i]))
+      skipped[i]++;
+  }
+  skipped[chosen] = 0;
+
+  return g_queue_pop_head(queues[chosen]);
 }
 
 void
-recalcRectangle(int page_id, PopplerRectangle* rectangle)
+cancel_jobs(GThreadFunc function, gboolean wait)
 {
-  double page_width, page_height;
-  double x1 = rectangle->x1;
-  double x2 = rectangle->x2;
-  double y1 = rectangle->y1;
-  double y2 = rectangle->y2;
+  if(!Zathura.Scheduler.count)
+    return;
 
-  g_static_mutex_lock(&(Zathura.Lock.pdflib_lock));
-  poppler_page_get_size(Zathura.PDF.pages[page_id]->page, &page_width, &page_height);
-  g_static_mutex_unlock(&(Zathura.Lock.pdflib_lock));
+  g_mutex_lock(Zathura.Scheduler.lock);
 
-  double scale = ((double) Zathura.PDF.scale / 100.0);
+  int i;
+  for(i = 0; i < JOB_CLASSES; i++)
+  {
+    GList* link = Zathura.Scheduler.queues[i]->head;
+    while(link)
+    {
+      GList* next = g_list_next(link);
+      Job* job    = (Job*) link->data;
 
-  int rotate = Zathura.PDF.rotate;
+      if(job->function == function)
+      {
+        if(job->destroy)
+          job->destroy(job->data);
+        free(job);
+        g_queue_delete_link(Zathura.Scheduler.queues[i], link);
+      }
 
-  switch(rotate)
+      link = next;
+    }
+  }
+
+  /* jobs that have been started already are run to their end */
+  while(wait)
   {
-    case 90:
-      rectangle->x1 = y2 * scale;
-      rectangle->y1 = x1 * scale;
-      rectangle->x2 = y1 * scale;
-      rectangle->y2 = x2 * scale;
-      break;
-    case 180:
-      rectangle->x1 = (page_width  - x2) * scale;
-      rectangle->y1 = y2 * scale;
-      rectangle->x2 = (page_width  - x1) * scale;
-      rectangle->y2 = y1 * scale;
-      break;
-    case 270:
-      rectangle->x1 = (page_height - y1) * scale;
-      rectangle->y1 = (page_width  - x2) * scale;
-      rectangle->x2 = (page_height - y2) * scale;
-      rectangle->y2 = (page_width  - x1) * scale;
+    GList* list;
+    for(list = Zathura.Scheduler.running; list; list = g_list_next(list))
+    {
+      if(((Job*) list->data)->function == function)
+        break;
+    }
+
+    if(!list)
       break;
-    default:
-      rectangle->x1 = x1  * scale;
-      rectangle->y1 = (page_height - y1) * scale;
-      rectangle->x2 = x2  * scale;
-      rectangle->y2 = (page_height - y2) * scale;
+
+    g_cond_wait(Zathura.Scheduler.finished, Zathura.Scheduler.lock);
   }
+
+  g_mutex_unlock(Zathura.Scheduler.lock);
 }
 
-GtkEventBox*
-createCompletionRow(GtkBox* results, char* command, char* description, gboolean group)
+void
+finish_jobs(GThreadFunc function)
 {
-  GtkBox      *col = GTK_BOX(gtk_hbox_new(FALSE, 0));
-  GtkEventBox *row = GTK_EVENT_BOX(gtk_event_box_new());
-
-  GtkLabel *show_command     = GTK_LABEL(gtk_label_new(NULL));
-  GtkLabel *show_description = GTK_LABEL(gtk_label_new(NULL));
+  if(!Zathura.Scheduler.count)
+    return;
 
-  gtk_misc_set_alignment(GTK_MISC(show_command),     0.0, 0.0);
-  gtk_misc_set_alignment(GTK_MISC(show_description), 0.0, 0.0);
+  g_mutex_lock(Zathura.Scheduler.lock);
 
-  if(group)
-  {
-    gtk_misc_set_padding(GTK_MISC(show_command),     2.0, 4.0);
-    gtk_misc_set_padding(GTK_MISC(show_description), 2.0, 4.0);
-  }
-  else
+  while(TRUE)
   {
-    gtk_misc_set_padding(GTK_MISC(show_command),     1.0, 1.0);
-    gtk_misc_set_padding(GTK_MISC(show_description), 1.0, 1.0);
-  }
+    gboolean pending = FALSE;
 
-  gtk_label_set_use_markup(show_command,     TRUE);
-  gtk_label_set_use_markup(show_description, TRUE);
+    GList* list;
+    for(list = Zathura.Scheduler.running; list && !pending; list = g_list_next(list))
+      pending = ((Job*) list->data)->function == function;
 
-  gtk_label_set_markup(show_command,     g_markup_printf_escaped(FORMAT_COMMAND,     command ? command : ""));
-  gtk_label_set_markup(show_description, g_markup_printf_escaped(FORMAT_DESCRIPTION, description ? description : ""));
+    int i;
+    for(i = 0; i < JOB_CLASSES && !pending; i++)
+    {
+      for(list = Zathura.Scheduler.queues[i]->head; list && !pending; list = g_list_next(list))
+        pending = ((Job*) list->data)->function == function;
+    }
 
-  if(group)
-  {
-    gtk_widget_modify_fg(GTK_WIDGET(show_command),     GTK_STATE_NORMAL, &(Zathura.Style.completion_g_fg));
-    gtk_widget_modify_fg(GTK_WIDGET(show_description), GTK_STATE_NORMAL, &(Zathura.Style.completion_g_fg));
-    gtk_widget_modify_bg(GTK_WIDGET(row),              GTK_STATE_NORMAL, &(Zathura.Style.completion_g_bg));
-  }
-  else
-  {
-    gtk_widget_modify_fg(GTK_WIDGET(show_command),     GTK_STATE_NORMAL, &(Zathura.Style.completion_fg));
-    gtk_widget_modify_fg(GTK_WIDGET(show_description), GTK_STATE_NORMAL, &(Zathura.Style.completion_fg));
-    gtk_widget_modify_bg(GTK_WIDGET(row),              GTK_STATE_NORMAL, &(Zathura.Style.completion_bg));
+    if(!pending)
+      break;
+
+    g_cond_wait(Zathura.Scheduler.finished, Zathura.Scheduler.lock);
   }
 
-  gtk_widget_modify_font(GTK_WIDGET(show_command),     Zathura.Style.font);
-  gtk_widget_modify_font(GTK_WIDGET(show_description), Zathura.Style.font);
+  g_mutex_unlock(Zathura.Scheduler.lock);
+}
 
-  gtk_box_pack_start(GTK_BOX(col), GTK_WIDGET(show_command),     TRUE,  TRUE,  2);
-  gtk_box_pack_start(GTK_BOX(col), GTK_WIDGET(show_description), FALSE, FALSE, 2);
+void
+pause_jobs()
+{
+  if(!Zathura.Scheduler.count)
+    return;
 
-  gtk_container_add(GTK_CONTAINER(row), GTK_WIDGET(col));
+  g_mutex_lock(Zathura.Scheduler.lock);
+  Zathura.Scheduler.visible++;
+  g_mutex_unlock(Zathura.Scheduler.lock);
+}
 
-  gtk_box_pack_start(results, GTK_WIDGET(row), FALSE, FALSE, 0);
+void
+resume_jobs()
+{
+  if(!Zathura.Scheduler.count)
+    return;
 
-  return row;
+  g_mutex_lock(Zathura.Scheduler.lock);
+  Zathura.Scheduler.visible--;
+  g_cond_broadcast(Zathura.Scheduler.wake);
+  g_mutex_unlock(Zathura.Scheduler.lock);
 }
 
-void
-setCompletionRowColor(GtkBox* results, int mode, int id)
+gint
+compare_jobs(gconstpointer a, gconstpointer b, gpointer data)
 {
-  GtkEventBox *row   = (GtkEventBox*) g_list_nth_data(gtk_container_get_children(GTK_CONTAINER(results)), id);
- 
-  if(row)
-  {
-    GtkBox      *col   = (GtkBox*)      g_list_nth_data(gtk_container_get_children(GTK_CONTAINER(row)), 0);
-    GtkLabel    *cmd   = (GtkLabel*)    g_list_nth_data(gtk_container_get_children(GTK_CONTAINER(col)), 0);
-    GtkLabel    *cdesc = (GtkLabel*)    g_list_nth_data(gtk_container_get_children(GTK_CONTAINER(col)), 1);
+  const Job* queued = (const Job*) a;
+  const Job* job    = (const Job*) b;
 
-    if(mode == NORMAL)
-    {
-      gtk_widget_modify_fg(GTK_WIDGET(cmd),   GTK_STATE_NORMAL, &(Zathura.Style.completion_fg));
-      gtk_widget_modify_fg(GTK_WIDGET(cdesc), GTK_STATE_NORMAL, &(Zathura.Style.completion_fg));
-      gtk_widget_modify_bg(GTK_WIDGET(row),   GTK_STATE_NORMAL, &(Zathura.Style.completion_bg));
-    }
-    else
-    {
-      gtk_widget_modify_fg(GTK_WIDGET(cmd),   GTK_STATE_NORMAL, &(Zathura.Style.completion_hl_fg));
-      gtk_widget_modify_fg(GTK_WIDGET(cdesc), GTK_STATE_NORMAL, &(Zathura.Style.completion_hl_fg));
-      gtk_widget_modify_bg(GTK_WIDGET(row),   GTK_STATE_NORMAL, &(Zathura.Style.completion_hl_bg));
-    }
-  }
+  /* jobs without an order of their own are run in the order they came */
+  if(!job->compare || queued->compare != job->compare)
+    return -1;
+
+  return (job->compare(queued->data, job->data, NULL) <= 0) ? -1 : 1;
 }
 
 void
-set_page(int page)
+cancel_prefetch()
 {
-  if(page > Zathura.PDF.number_of_pages || page < 0)
-  {
-    notify(WARNING, "Could not open page");
+  /* the pages being rendered refer to the mapping of the document */
+  cancel_jobs(prefetch_page, TRUE);
+  g_hash_table_remove_all(Zathura.Cache.prefetching);
+}
+
+void
+request_prefetch(int page_id, int priority, int job_priority)
+{
+  load_page(page_id);
+
+  if(find_raster(page_id) || g_hash_table_lookup(Zathura.Cache.prefetching, GINT_TO_POINTER(page_id + 1)))
     return;
-  }
 
-  Zathura.PDF.page_number = page;
+  /* pages that are at hand only have to be unpacked or mapped */
+  Zathura.Cache.clock++;
+  if(unpack_raster(page_id, priority) || load_disk_raster(page_id, priority))
+    return;
 
-  Argument argument;
-  argument.n = TOP;
-  sc_scroll(&argument);
+  /* get_raster only lowers the resolution of visible pages, a page that
+   * would not be kept is not rendered at all */
+  double width, height;
+  get_page_size(page_id, &width, &height);
+  if(!make_room((gsize) cairo_format_stride_for_width(CAIRO_FORMAT_RGB24, width) * (int) height, priority))
+    return;
 
-  switch_view(Zathura.UI.drawing_area);
-  draw(page);
+  /* the others are rendered by a worker while the main loop goes on, from
+   * their display list if they have one */
+  cairo_surface_t* recording = get_recording(page_id, FALSE);
+
+  Prefetch* prefetch = malloc(sizeof(Prefetch));
+  prefetch->page     = page_id;
+  prefetch->scale    = Zathura.PDF.scale;
+  prefetch->rotate   = Zathura.PDF.rotate;
+  prefetch->recolor  = Zathura.Global.recolor;
+  prefetch->priority = priority;
+  prefetch->source    = g_object_ref(Zathura.PDF.pages[page_id]->page);
+  prefetch->recording = recording ? cairo_surface_reference(recording) : NULL;
+  prefetch->surface   = NULL;
+  prefetch->time      = 0;
+
+  g_hash_table_insert(Zathura.Cache.prefetching, GINT_TO_POINTER(page_id + 1), GINT_TO_POINTER(TRUE));
+
+  if(!push_job(prefetch_page, prefetch, job_priority, free_prefetch, NULL))
+    prefetch_page(prefetch);
 }
 
 void
-switch_view(GtkWidget* widget)
+add_jump_target(int* targets, int* number_of_targets, int page_id)
 {
-  GtkWidget* child = gtk_bin_get_child(GTK_BIN(Zathura.UI.viewport));
-  if(child)
+  if(*number_of_targets >= JUMP_TARGETS || page_id < 0 || page_id >= Zathura.PDF.number_of_pages ||
+      page_id == Zathura.PDF.page_number)
+    return;
+
+  int i;
+  for(i = 0; i < *number_of_targets; i++)
   {
-    g_object_ref(child);
-    gtk_container_remove(GTK_CONTAINER(Zathura.UI.viewport), child);
+    if(targets[i] == page_id)
+      return;
   }
 
-  gtk_container_add(GTK_CONTAINER(Zathura.UI.viewport), GTK_WIDGET(widget));
+  targets[(*number_of_targets)++] = page_id;
 }
 
-/* thread implementation */
-void*
-search(void* parameter)
+void
+free_prefetch(gpointer data)
 {
-  Argument* argument = (Argument*) parameter;
+  Prefetch* prefetch = (Prefetch*) data;
+
+  if(prefetch->surface)
+    cairo_surface_destroy(prefetch->surface);
+  if(prefetch->recording)
+    cairo_surface_destroy(prefetch->recording);
+  g_object_unref(prefetch->source);
+  free(prefetch);
+}
 
-  static char* search_item;
-  static int direction;
-  static int next_page = 0;
-  int page_counter;
-  GList* results = NULL;
-  GList* list    = NULL;
+void
+free_argument(gpointer data)
+{
+  Argument* argument = (Argument*) data;
 
-  if(argument->data)
-    search_item = g_strdup((char*) argument->data);
+  g_free(argument->data);
+  free(argument);
+}
 
-  g_static_mutex_lock(&(Zathura.Lock.document_lock));
-  if(!Zathura.PDF.document || !search_item || !strlen(search_item))
-  {
-    g_static_mutex_lock(&(Zathura.Lock.document_lock));
-    g_static_mutex_lock(&(Zathura.Lock.search_lock));
-    Zathura.Thread.search_thread_running = FALSE;
-    g_static_mutex_unlock(&(Zathura.Lock.search_lock));
-    g_thread_exit(NULL);
-  }
-  g_static_mutex_unlock(&(Zathura.Lock.document_lock));
+cairo_surface_t*
+render_page(PopplerPage* page, int scale_level, int rotate, GStaticMutex* lock, double* time)
+{
+  double page_width, page_height;
+  double width, height;
 
-  /* search document */
-  if(argument->n)
-    direction = (argument->n == BACKWARD) ? -1 : 1;
+  double scale = ((double) scale_level / 100.0);
 
-  int number_of_pages = Zathura.PDF.number_of_pages;
-  int page_number     = Zathura.PDF.page_number;
+  /* a document that is used by a single thread needs no lock */
+  if(lock)
+    g_static_mutex_lock(lock);
+  poppler_page_get_size(page, &page_width, &page_height);
+  if(lock)
+    g_static_mutex_unlock(lock);
 
-  for(page_counter = 1; page_counter <= Zathura.PDF.number_of_pages; page_counter++)
+  if(rotate == 0 || rotate == 180)
   {
-    g_static_mutex_lock(&(Zathura.Lock.search_lock));
-    if(Zathura.Thread.search_thread_running == FALSE)
-    {
-      g_static_mutex_unlock(&(Zathura.Lock.search_lock));
-      g_thread_exit(NULL);
-    }
-    g_static_mutex_unlock(&(Zathura.Lock.search_lock));
+    width  = page_width  * scale;
+    height = page_height * scale;
+  }
+  else
+  {
+    width  = page_height * scale;
+    height = page_width  * scale;
+  }
 
-    next_page = (number_of_pages + page_number +
-        page_counter * direction) % number_of_pages;
+  cairo_t *cairo;
+  cairo_surface_t* surface = create_surface(CAIRO_FORMAT_RGB24, width, height);
+  cairo = cairo_create(surface);
 
-    g_static_mutex_lock(&(Zathura.Lock.pdflib_lock));
-    PopplerPage* page = poppler_document_get_page(Zathura.PDF.document, next_page);
-    g_static_mutex_unlock(&(Zathura.Lock.pdflib_lock));
+  cairo_save(cairo);
+  cairo_set_source_rgb(cairo, 1, 1, 1);
+  cairo_rectangle(cairo, 0, 0, width, height);
+  cairo_fill(cairo);
+  cairo_restore(cairo);
+  cairo_save(cairo);
 
-    if(!page)
-      g_thread_exit(NULL);
+  transform_page(cairo, scale, rotate, width, height);
 
-    g_static_mutex_lock(&(Zathura.Lock.pdflib_lock));
-    results = poppler_page_find_text(page, search_item);
-    g_static_mutex_unlock(&(Zathura.Lock.pdflib_lock));
+  if(lock)
+    g_static_mutex_lock(lock);
 
-    if(results)
-      break;
-  }
+  /* only poppler's own time is taken, not the wait for the lock */
+  GTimer* timer = time ? g_timer_new() : NULL;
+  poppler_page_render(page, cairo);
 
-  /* draw results */
-  if(results)
+  if(timer)
   {
-    gdk_threads_enter();
-
-    set_page(next_page);
-
-    for(list = results; list && list->data; list = g_list_next(list))
-      highlight_result(next_page, (PopplerRectangle*) list->data);
-
-    gdk_threads_leave();
+    *time = g_timer_elapsed(timer, NULL);
+    g_timer_destroy(timer);
   }
 
-  g_static_mutex_lock(&(Zathura.Lock.search_lock));
-  Zathura.Thread.search_thread_running = FALSE;
-  g_static_mutex_unlock(&(Zathura.Lock.search_lock));
+  if(lock)
+    g_static_mutex_unlock(lock);
 
-  g_thread_exit(NULL);
-  return NULL;
+  cairo_restore(cairo);
+  cairo_destroy(cairo);
+
+  return surface;
 }
 
-void*
-watch_file(void* parameter)
+void
+recolor_surface(cairo_surface_t* surface)
 {
-  int blen = sizeof(struct inotify_event);
+  unsigned char* image = cairo_image_surface_get_data(surface);
+  int x, y;
 
-  while(1)
-  {
-    /* wait for event */
-    char buf[blen];
-    if(read(Zathura.Inotify.fd, buf, blen) < 0)
-      continue;
+  int width     = cairo_image_surface_get_width(surface);
+  int height    = cairo_image_surface_get_height(surface);
+  int rowstride = cairo_image_surface_get_stride(surface);
 
-    /* process event */
-    struct inotify_event *event = (struct inotify_event*) buf;
-    if(event->mask & IN_CLOSE_WRITE)
-    {
-      /* save old information */
-      char* path     = Zathura.PDF.file ? strdup(Zathura.PDF.file) : NULL;
-      char* password = Zathura.PDF.password ? strdup(Zathura.PDF.password) : NULL;
-      int scale      = Zathura.PDF.scale;
-      int page       = Zathura.PDF.page_number;
+  /* recolor code based on qimageblitz library flatten() function
+  (http://sourceforge.net/projects/qimageblitz/) */
 
-      /* reopen and restore settings */
-      gdk_threads_enter();
+  int r1 = Zathura.Style.recolor_darkcolor.red    / 257;
+  int g1 = Zathura.Style.recolor_darkcolor.green  / 257;
+  int b1 = Zathura.Style.recolor_darkcolor.blue   / 257;
+  int r2 = Zathura.Style.recolor_lightcolor.red   / 257;
+  int g2 = Zathura.Style.recolor_lightcolor.green / 257;
+  int b2 = Zathura.Style.recolor_lightcolor.blue  / 257;
 
-      cmd_close(0, NULL);
-      open_file(path, password);
-      
-      Zathura.PDF.scale = scale;
+  int min = 0x00;
+  int max = 0xFF;
+  int mean;
 
-      draw(page);
-      gdk_threads_leave();
+  float sr = ((float) r2 - r1) / (max - min);
+  float sg = ((float) g2 - g1) / (max - min);
+  float sb = ((float) b2 - b1) / (max - min);
 
-      break;
+  for (y = 0; y < height; y++) 
+  {
+    unsigned char* data = image + y * rowstride;
+
+    for (x = 0; x < width; x++) 
+    {
+      mean = (data[0] + data[1] + data[2]) / 3;
+      data[2] = sr * (mean - min) + r1 + 0.5;
+      data[1] = sg * (mean - min) + g1 + 0.5;
+      data[0] = sb * (mean - min) + b1 + 0.5;
+      data += 4;
     }
   }
-
-  g_thread_exit(NULL);
-  return NULL;
 }
 
-/* shortcut implementation */
 void
-sc_abort(Argument* argument)
+get_page_size(int page_id, double* width, double* height)
 {
-  /* Clear buffer */
-  if(Zathura.Global.buffer)
+  double page_width, page_height;
+  double scale = ((double) Zathura.PDF.scale / 100.0);
+
+  g_static_mutex_lock(&(Zathura.Lock.pdflib_lock));
+  poppler_page_get_size(Zathura.PDF.pages[page_id]->page, &page_width, &page_height);
+  g_static_mutex_unlock(&(Zathura.Lock.pdflib_lock));
+
+  if(Zathura.PDF.rotate == 0 || Zathura.PDF.rotate == 180)
   {
-    g_string_free(Zathura.Global.buffer, TRUE);
-    Zathura.Global.buffer = NULL;
-    gtk_label_set_markup((GtkLabel*) Zathura.Global.status_buffer, "");
+    *width  = page_width  * scale;
+    *height = page_height * scale;
+  }
+  else
+  {
+    *width  = page_height * scale;
+    *height = page_width  * scale;
   }
-
-  /* Set back to normal mode */
-  change_mode(NORMAL);
-  switch_view(Zathura.UI.drawing_area);
 }
 
-void
-sc_adjust_window(Argument* argument)
+cairo_surface_t*
+get_raster(int page_id, int priority)
 {
-  if(!Zathura.PDF.document)
-    return;
-
-  Zathura.Global.adjust_mode = argument->n;
+  Zathura.Cache.clock++;
 
-  GtkAdjustment* adjustment;
-  double view_size;
-  double page_width;
-  double page_height;
+  /* the budget might have been lowered */
+  make_room(0, PRIORITY_VISIBLE);
 
-  if(argument->n == ADJUST_BESTFIT)
-    adjustment = gtk_scrolled_window_get_vadjustment(Zathura.UI.view);
-  else if(argument->n == ADJUST_WIDTH)
-    adjustment = gtk_scrolled_window_get_hadjustment(Zathura.UI.view);
-  else
-    return;
+  Raster* raster = lookup_raster(page_id, priority);
+  if(raster)
+    return cairo_surface_reference(raster->surface);
 
-  view_size  = gtk_adjustment_get_page_size(adjustment);
+  /* the size of the raster exactly as cairo allocates it */
+  double width, height;
+  get_page_size(page_id, &width, &height);
 
-  g_static_mutex_lock(&(Zathura.Lock.pdflib_lock));
-  poppler_page_get_size(Zathura.PDF.pages[Zathura.PDF.page_number]->page, &page_width, &page_height);
-  g_static_mutex_unlock(&(Zathura.Lock.pdflib_lock));
+  int render_scale = Zathura.PDF.scale;
+  gsize size = (gsize) cairo_format_stride_for_width(CAIRO_FORMAT_RGB24, width) * (int) height;
 
-  if ((Zathura.PDF.rotate == 90) || (Zathura.PDF.rotate == 270))
+  /* a page that does not fit into the budget is rendered at a lower resolution */
+  if(!make_room(size, priority))
   {
-    double swap = page_width;
-    page_width  = page_height;
-    page_height = swap;
+    if(priority != PRIORITY_VISIBLE)
+      return NULL;
+
+    gsize budget = (gsize) MAX(Zathura.Cache.size, 0) << 20;
+    gsize room   = (budget > Zathura.Cache.used) ? budget - Zathura.Cache.used : 0;
+
+    while(size > room && render_scale > 1)
+    {
+      render_scale = render_scale * 9 / 10;
+      int render_width  = width  * render_scale / Zathura.PDF.scale;
+      int render_height = height * render_scale / Zathura.PDF.scale;
+      size = (gsize) cairo_format_stride_for_width(CAIRO_FORMAT_RGB24, render_width) * render_height;
+    }
   }
 
-  if(argument->n == ADJUST_BESTFIT)
-    Zathura.PDF.scale = (view_size / page_height) * 100;
-  else
-    Zathura.PDF.scale = (view_size / page_width) * 100;
+  /* a page that is rendered again, e.g. at another zoom level, is replayed
+   * from its display list instead of being interpreted by poppler */
+  gboolean rendered = g_hash_table_lookup(Zathura.Cache.rendered, GINT_TO_POINTER(page_id)) != NULL;
+  g_hash_table_insert(Zathura.Cache.rendered, GINT_TO_POINTER(page_id), GINT_TO_POINTER(TRUE));
 
-  draw(Zathura.PDF.page_number);
-}
+  cairo_surface_t* surface   = NULL;
+  cairo_surface_t* recording = get_recording(page_id, rendered);
 
-void
-sc_change_buffer(Argument* argument)
-{
-  if(!Zathura.Global.buffer)
-    return;
+  if(recording)
+    surface = replay_page(Zathura.PDF.pages[page_id]->page, recording, render_scale, Zathura.PDF.rotate);
 
-  int buffer_length = Zathura.Global.buffer->len;
+  /* the time poppler takes is remembered for prefetching */
+  gboolean replayed = surface != NULL;
+  double time       = 0;
 
-  if(argument->n == DELETE_LAST)
-  {
-    if((buffer_length - 1) == 0)
-    {
-      g_string_free(Zathura.Global.buffer, TRUE);
-      Zathura.Global.buffer = NULL;
-      gtk_label_set_markup((GtkLabel*) Zathura.Global.status_buffer, "");
-    }
-    else
-    {
-      GString* temp = g_string_new_len(Zathura.Global.buffer->str, buffer_length - 1);
-      g_string_free(Zathura.Global.buffer, TRUE);
-      Zathura.Global.buffer = temp;
-      gtk_label_set_markup((GtkLabel*) Zathura.Global.status_buffer, Zathura.Global.buffer->str);
-    }
-  }
+  /* a page at full resolution is split across the processors */
+  if(!surface && tile_count() > 1 && render_scale == Zathura.PDF.scale)
+    surface = render_tiled(page_id, render_scale, Zathura.PDF.rotate, &time);
+
+  if(!surface)
+    surface = render_page(Zathura.PDF.pages[page_id]->page, render_scale, Zathura.PDF.rotate,
+        &(Zathura.Lock.pdflib_lock), &time);
+
+  if(!replayed)
+    record_cost(page_id, surface, time);
+
+  raster = finish_raster(page_id, render_scale, priority, surface);
 
+  return cairo_surface_reference(raster->surface);
 }
 
-void
-sc_change_mode(Argument* argument)
+Raster*
+lookup_raster(int page_id, int priority)
 {
-  if(argument)
-    change_mode(argument->n);
+  Raster* raster = find_raster(page_id);
+  if(raster)
+  {
+    raster->last_used = Zathura.Cache.clock;
+    if(priority < raster->priority)
+      raster->priority = priority;
+
+    Zathura.Cache.hits++;
+    return raster;
+  }
+
+  /* pages that were pushed out of the cache only have to be unpacked */
+  raster = unpack_raster(page_id, priority);
+  if(raster)
+    return raster;
+
+  /* pages of an earlier session are mapped from the disk */
+  return load_disk_raster(page_id, priority);
 }
 
-void 
-sc_focus_inputbar(Argument* argument)
+Raster*
+find_raster(int page_id)
 {
-  if(argument->data)
+  GList* list;
+  for(list = Zathura.Cache.rasters; list; list = g_list_next(list))
   {
-    notify(DEFAULT, argument->data);
-    gtk_widget_grab_focus(GTK_WIDGET(Zathura.UI.inputbar));
-    gtk_editable_set_position(GTK_EDITABLE(Zathura.UI.inputbar), -1);
+    Raster* raster = (Raster*) list->data;
+
+    /* gray rasters are recolored when they are painted */
+    if((raster->page == page_id || g_list_find(raster->aliases, GINT_TO_POINTER(page_id))) &&
+        raster->scale == Zathura.PDF.scale && raster->rotate == Zathura.PDF.rotate &&
+        (raster->recolor == Zathura.Global.recolor ||
+         cairo_image_surface_get_format(raster->surface) == CAIRO_FORMAT_A8))
+      return raster;
   }
+
+  return NULL;
 }
 
-void
-sc_follow(Argument* argument)
+Raster*
+finish_raster(int page_id, int render_scale, int priority, cairo_surface_t* surface)
 {
-  if(!Zathura.PDF.document)
-    return;
+  /* pages without colors only keep their ink coverage */
+  cairo_surface_t* gray = gray_surface(surface);
 
-  Page* current_page = Zathura.PDF.pages[Zathura.PDF.page_number];
-  int number_of_links = 0, link_id = 1;
+  if(gray)
+  {
+    cairo_surface_destroy(surface);
+    surface = gray;
+  }
+  else if(Zathura.Global.recolor)
+    recolor_surface(surface);
 
-  g_static_mutex_lock(&(Zathura.Lock.pdflib_lock));
-  GList *link_list = poppler_page_get_link_mapping(current_page->page);
-  g_static_mutex_unlock(&(Zathura.Lock.pdflib_lock));
-  link_list = g_list_reverse(link_list);
+  save_disk_raster(page_id, render_scale, surface);
 
-  if((number_of_links = g_list_length(link_list)) <= 0)
-    return;
+  /* pages that look exactly the same share one raster */
+  cairo_surface_flush(surface);
+  guint32 checksum = raster_checksum(cairo_image_surface_get_data(surface),
+      (gsize) cairo_image_surface_get_stride(surface) * cairo_image_surface_get_height(surface));
 
-  GList *links;
-  for(links = link_list; links; links = g_list_next(links))
+  Raster* raster = find_shared_raster(surface, checksum, render_scale);
+  if(raster)
   {
-    PopplerLinkMapping *link_mapping = (PopplerLinkMapping*) links->data;
-    PopplerRectangle* link_rectangle = &link_mapping->area;
-    PopplerAction            *action = link_mapping->action;
+    cairo_surface_destroy(surface);
 
-    /* only handle URI and internal links */
-    if(action->type == POPPLER_ACTION_URI || action->type == POPPLER_ACTION_GOTO_DEST)
-    {
-      highlight_result(Zathura.PDF.page_number, link_rectangle);
+    raster->aliases   = g_list_prepend(raster->aliases, GINT_TO_POINTER(page_id));
+    raster->last_used = Zathura.Cache.clock;
+    if(priority < raster->priority)
+      raster->priority = priority;
 
-      /* draw text */
-      cairo_t *cairo = cairo_create(Zathura.PDF.surface);
-      cairo_select_font_face(cairo, font, CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_BOLD);
-      cairo_set_font_size(cairo, 10);
-      cairo_move_to(cairo, link_rectangle->x1 + 1, link_rectangle->y1 - 1);
-      cairo_show_text(cairo, g_strdup_printf("%i", link_id++));
-    }
+    Zathura.Cache.shared++;
+    return raster;
   }
 
-  gtk_widget_queue_draw(Zathura.UI.drawing_area);
-  poppler_page_free_link_mapping(link_list);
-
-  /* replace default inputbar handler */
-  g_signal_handler_disconnect((gpointer) Zathura.UI.inputbar, Zathura.Handler.inputbar_activate);
-  Zathura.Handler.inputbar_activate = g_signal_connect(G_OBJECT(Zathura.UI.inputbar), "activate", G_CALLBACK(cb_inputbar_form_activate), NULL);
+  raster           = store_raster(page_id, render_scale, priority, surface);
+  raster->checksum = checksum;
 
-  argument->data = "Follow hint: ";
-  sc_focus_inputbar(argument);
+  return raster;
 }
 
 void
-sc_navigate(Argument* argument)
+get_view_size(int page_id, double* width, double* height)
 {
-  if(!Zathura.PDF.document)
-    return;
+  int left, right;
+  spread_pages(page_id, &left, &right);
 
-  int number_of_pages = Zathura.PDF.number_of_pages;
-  int new_page = Zathura.PDF.page_number;
+  get_page_size(left, width, height);
 
-  if(argument->n == NEXT)
-    new_page = (new_page + number_of_pages + 1) % number_of_pages;
-  else if(argument->n == PREVIOUS)  
-    new_page = (new_page + number_of_pages - 1) % number_of_pages;
+  if(right != -1)
+  {
+    double right_width, right_height;
+    get_page_size(right, &right_width, &right_height);
 
-  set_page(new_page);
-  update_status();
+    *width  += right_width;
+    *height  = MAX(*height, right_height);
+  }
 }
 
 void
-sc_recolor(Argument* argument)
+spread_pages(int page_id, int* left, int* right)
 {
-  Zathura.Global.recolor = !Zathura.Global.recolor;
-  draw(Zathura.PDF.page_number);
+  *left  = page_id;
+  *right = -1;
+
+  /* the cover of a book is shown on its own */
+  int first = Zathura.Global.spread_cover ? 1 : 0;
+  if(!Zathura.Global.spread || page_id < first)
+    return;
+
+  *left = page_id - (page_id - first) % 2;
+  if(*left + 1 < Zathura.PDF.number_of_pages)
+    *right = *left + 1;
+
+  load_page(*left);
+  if(*right != -1)
+    load_page(*right);
 }
 
-void
-sc_rotate(Argument* argument)
+cairo_surface_t**
+page_surface(int page_id)
 {
-  Zathura.PDF.rotate = (Zathura.PDF.rotate + 90) % 360;
+  /* the pages of a spread are kept apart and only put next to each other
+   * when they are uploaded */
+  int left, right;
+  spread_pages(Zathura.PDF.page_number, &left, &right);
 
-  draw(Zathura.PDF.page_number);
+  return (Zathura.PDF.spread && page_id == right) ? &(Zathura.PDF.spread) : &(Zathura.PDF.surface);
 }
 
 void
-sc_scroll(Argument* argument)
+render_spread(int left, int right)
 {
-  GtkAdjustment* adjustment;
-
-  if( (argument->n == LEFT) || (argument->n == RIGHT) )
-    adjustment = gtk_scrolled_window_get_hadjustment(Zathura.UI.view);
-  else
-    adjustment = gtk_scrolled_window_get_vadjustment(Zathura.UI.view);
+  /* the right page is taken from the caches like any other, the left one
+   * might push it out again before it is painted */
+  Zathura.Cache.clock++;
+  Raster* raster = lookup_raster(right, PRIORITY_VISIBLE);
+  if(raster)
+    Zathura.PDF.spread = cairo_surface_reference(raster->surface);
+
+  /* a page that has to be rendered is rendered by a document of its own
+   * while the left one is rendered here, unless it is replayed from its
+   * display list or does not fit into the budget at full resolution */
+  Tile tile;
+  GThread* worker = NULL;
+
+  get_page_size(right, &tile.width, &tile.height);
+  gsize size = (gsize) cairo_format_stride_for_width(CAIRO_FORMAT_RGB24, tile.width) * (int) tile.height;
+
+  if(Zathura.Tiles.spread && !copies_current())
+  {
+    g_object_unref(Zathura.Tiles.spread);
+    Zathura.Tiles.spread = NULL;
+  }
 
-  gdouble view_size  = gtk_adjustment_get_page_size(adjustment);
-  gdouble value      = gtk_adjustment_get_value(adjustment);
-  gdouble max        = gtk_adjustment_get_upper(adjustment) - view_size;
+  if(!Zathura.PDF.spread && !Zathura.Tiles.spread)
+    Zathura.Tiles.spread = copy_document();
 
-  if( (argument->n == LEFT) || (argument->n == UP))
-    gtk_adjustment_set_value(adjustment, (value - SCROLL_STEP) < 0 ? 0 : (value - SCROLL_STEP));
-  else if (argument->n == TOP)
-    gtk_adjustment_set_value(adjustment, 0);
-  else if(argument->n == BOTTOM)
-    gtk_adjustment_set_value(adjustment, max);
-  else
-    gtk_adjustment_set_value(adjustment, (value + SCROLL_STEP) > max ? max : (value + SCROLL_STEP));
+  if(!Zathura.PDF.spread && Zathura.Tiles.spread &&
+      !g_hash_table_lookup(Zathura.Cache.rendered, GINT_TO_POINTER(right)) &&
+      make_room(size, PRIORITY_VISIBLE))
+  {
+    tile.document = Zathura.Tiles.spread;
+    tile.page     = right;
+    tile.scale    = Zathura.PDF.scale;
+    tile.rotate   = Zathura.PDF.rotate;
+    tile.y        = 0;
+    tile.surface  = create_surface(CAIRO_FORMAT_RGB24, tile.width, tile.height);
+
+    worker = g_thread_create(render_tile, &tile, TRUE, NULL);
+    if(!worker)
+      cairo_surface_destroy(tile.surface);
+  }
 
-  update_status();
-}
+  Zathura.PDF.surface = get_raster(left, PRIORITY_VISIBLE);
 
-void
-sc_search(Argument* argument)
-{
-  g_static_mutex_lock(&(Zathura.Lock.search_lock));
-  if(Zathura.Thread.search_thread_running)
+  if(worker)
   {
-    Zathura.Thread.search_thread_running = FALSE;
-    g_static_mutex_unlock(&(Zathura.Lock.search_lock));
-    gdk_threads_leave();
-    g_thread_join(Zathura.Thread.search_thread);
-    gdk_threads_enter();
-    g_static_mutex_lock(&(Zathura.Lock.search_lock));
+    g_thread_join(worker);
+
+    cairo_surface_mark_dirty(tile.surface);
+    g_hash_table_insert(Zathura.Cache.rendered, GINT_TO_POINTER(right), GINT_TO_POINTER(TRUE));
+    record_cost(right, tile.surface, tile.time);
+
+    /* the left page may have taken the room, the page is then rendered
+     * again at the resolution that is left */
+    if(make_room(size, PRIORITY_VISIBLE))
+    {
+      raster             = finish_raster(right, Zathura.PDF.scale, PRIORITY_VISIBLE, tile.surface);
+      Zathura.PDF.spread = cairo_surface_reference(raster->surface);
+    }
+    else
+      cairo_surface_destroy(tile.surface);
   }
 
-  Zathura.Thread.search_thread_running = TRUE;
-  Zathura.Thread.search_thread = g_thread_create(search, (gpointer) argument, TRUE, NULL);
-  g_static_mutex_unlock(&(Zathura.Lock.search_lock));
+  if(!Zathura.PDF.spread)
+    Zathura.PDF.spread = get_raster(right, PRIORITY_VISIBLE);
 }
 
-void
-sc_switch_goto_mode(Argument* argument)
+Raster*
+find_shared_raster(cairo_surface_t* surface, guint32 checksum, int render_scale)
 {
-  switch(Zathura.Global.goto_mode)
+  cairo_format_t format = cairo_image_surface_get_format(surface);
+  int width             = cairo_image_surface_get_width(surface);
+  int height            = cairo_image_surface_get_height(surface);
+  int rowstride         = cairo_image_surface_get_stride(surface);
+
+  GList* list;
+  for(list = Zathura.Cache.rasters; list; list = g_list_next(list))
   {
-    case GOTO_LABELS:
-      Zathura.Global.goto_mode = GOTO_OFFSET;
-      break;
-    case GOTO_OFFSET:
-      Zathura.Global.goto_mode = GOTO_DEFAULT;
-      break;
-    default:
-      if(Zathura.Global.enable_labelmode)
-        Zathura.Global.goto_mode = GOTO_LABELS;
-      else
-        Zathura.Global.goto_mode = GOTO_OFFSET;
-      break;
+    Raster* raster = (Raster*) list->data;
+
+    if(!raster->checksum || raster->checksum != checksum || raster->render_scale != render_scale ||
+        raster->scale != Zathura.PDF.scale || raster->rotate != Zathura.PDF.rotate ||
+        cairo_image_surface_get_format(raster->surface) != format ||
+        cairo_image_surface_get_width(raster->surface) != width ||
+        cairo_image_surface_get_height(raster->surface) != height ||
+        (raster->recolor != Zathura.Global.recolor && format != CAIRO_FORMAT_A8))
+      continue;
+
+    /* the checksum only preselects, the pixels have to be the same */
+    if(!memcmp(cairo_image_surface_get_data(raster->surface), cairo_image_surface_get_data(surface),
+          (gsize) rowstride * height))
+      return raster;
   }
 
-  update_status();
+  return NULL;
 }
 
-gboolean cb_index_row_activated(GtkTreeView* treeview, GtkTreePath* path,
-  GtkTreeViewColumn* column, gpointer user_data)
+Raster*
+store_raster(int page_id, int render_scale, int priority, cairo_surface_t* surface)
 {
-  GtkTreeModel  *model;
-  GtkTreeIter   iter;
+  Raster* raster       = malloc(sizeof(Raster));
+  raster->page         = page_id;
+  raster->scale        = Zathura.PDF.scale;
+  raster->rotate       = Zathura.PDF.rotate;
+  raster->recolor      = Zathura.Global.recolor;
+  raster->render_scale = render_scale;
+  raster->priority     = priority;
+  raster->surface      = surface;
+  raster->size         = (gsize) cairo_image_surface_get_stride(surface) * cairo_image_surface_get_height(surface);
+  raster->last_used    = Zathura.Cache.clock;
+  raster->checksum     = 0;
+  raster->aliases      = NULL;
+
+  Zathura.Cache.rasters = g_list_prepend(Zathura.Cache.rasters, raster);
+  Zathura.Cache.used   += raster->size;
+
+  return raster;
+}
 
-  g_object_get(treeview, "model", &model, NULL);
+void
+pack_raster(Raster* raster)
+{
+  if(Zathura.Cache.packed_size <= 0 || Zathura.Pressure.active)
+    return;
 
-  if(gtk_tree_model_get_iter(model, &iter, path))
+  cairo_surface_t* surface = raster->surface;
+  cairo_surface_flush(surface);
+
+  cairo_format_t format = cairo_image_surface_get_format(surface);
+  unsigned char* image  = cairo_image_surface_get_data(surface);
+  int width             = cairo_image_surface_get_width(surface);
+  int height            = cairo_image_surface_get_height(surface);
+  int rowstride         = cairo_image_surface_get_stride(surface);
+  int bpp               = (format == CAIRO_FORMAT_A8) ? 1 : 4;
+
+  /* every row is run length encoded on its own: a control byte with the
+   * high bit set repeats the following pixel up to 128 times, otherwise it
+   * is followed by up to 128 literal pixels; short runs between single
+   * pixels can take a control byte per pixel, which is the worst case */
+  guchar* data = g_malloc((gsize) height * width * (bpp + 1));
+  guchar* out  = data;
+
+  int y;
+  for(y = 0; y < height; y++)
   {
-    PopplerAction* action;
-    PopplerDest*   destination;
-
-    gtk_tree_model_get(model, &iter, 1, &action, -1);
-    if(!action)
-      return TRUE;
+    unsigned char* row = image + y * rowstride;
+    int x = 0;
 
-    if(action->type == POPPLER_ACTION_GOTO_DEST)
+    while(x < width)
     {
-      destination = action->goto_dest.dest;
-      int page_number = destination->page_num;
+      int run = 1;
+      while(x + run < width && run < 128 && !memcmp(row + (x + run) * bpp, row + x * bpp, bpp))
+        run++;
 
-      if(action->goto_dest.dest->type == POPPLER_DEST_NAMED)
+      if(run > 1)
       {
-        PopplerDest* d = poppler_document_find_dest(Zathura.PDF.document, action->goto_dest.dest->named_dest);
-        if(d)
-        {
-          page_number = d->page_num;
-          poppler_dest_free(d);
-        }
+        *out++ = 0x80 | (run - 1);
+        memcpy(out, row + x * bpp, bpp);
+        out += bpp;
+        x   += run;
+        continue;
       }
 
-      set_page(page_number - 1);
-      update_status();
-      gtk_widget_grab_focus(GTK_WIDGET(Zathura.UI.view));
+      int start = x;
+      while(x < width && x - start < 128 &&
+          (x + 1 == width || memcmp(row + (x + 1) * bpp, row + x * bpp, bpp)))
+        x++;
+
+      *out++ = x - start - 1;
+      memcpy(out, row + start * bpp, (x - start) * bpp);
+      out += (x - start) * bpp;
     }
   }
 
-  Zathura.Global.mode = NORMAL;
-  g_object_unref(model);
+  gsize length = out - data;
+  gsize budget = (gsize) Zathura.Cache.packed_size << 20;
 
-  return TRUE;
+  /* pages that do not get smaller are not worth unpacking */
+  if(length > budget || length >= (gsize) height * width * bpp)
+  {
+    g_free(data);
+    return;
+  }
+
+  trim_packed(length);
+
+  Packed* packed       = malloc(sizeof(Packed));
+  packed->page         = raster->page;
+  packed->scale        = raster->scale;
+  packed->rotate       = raster->rotate;
+  packed->recolor      = raster->recolor;
+  packed->render_scale = raster->render_scale;
+  packed->format       = format;
+  packed->width        = width;
+  packed->height       = height;
+  packed->data         = g_realloc(data, length);
+  packed->length       = length;
+  packed->last_used    = Zathura.Cache.clock;
+
+  Zathura.Cache.packed       = g_list_prepend(Zathura.Cache.packed, packed);
+  Zathura.Cache.packed_used += length;
 }
 
-void
-sc_navigate_index(Argument* argument)
+Raster*
+unpack_raster(int page_id, int priority)
 {
-  GtkTreeView *treeview = gtk_container_get_children(GTK_CONTAINER(Zathura.UI.index))->data;
-  GtkTreePath *path;
+  Packed* packed = NULL;
 
-  gtk_tree_view_get_cursor(treeview, &path, NULL);
-  if(!path)
-    return;
+  GList* list;
+  for(list = Zathura.Cache.packed; list; list = g_list_next(list))
+  {
+    Packed* candidate = (Packed*) list->data;
 
-  GtkTreeModel *model = gtk_tree_view_get_model(treeview);
-  GtkTreeIter   iter;
-  GtkTreeIter   child_iter;
+    if(candidate->page == page_id && candidate->scale == Zathura.PDF.scale &&
+        candidate->rotate == Zathura.PDF.rotate &&
+        (candidate->recolor == Zathura.Global.recolor || candidate->format == CAIRO_FORMAT_A8))
+    {
+      packed = candidate;
+      break;
+    }
+  }
 
-  gboolean is_valid_path = TRUE;
+  if(!packed)
+  {
+    Zathura.Cache.packed_misses++;
+    return NULL;
+  }
 
-  switch(argument->n)
+  /* make_room() might pack other rasters, so this one is taken out first */
+  Zathura.Cache.packed       = g_list_remove(Zathura.Cache.packed, packed);
+  Zathura.Cache.packed_used -= packed->length;
+
+  gsize size = (gsize) cairo_format_stride_for_width(packed->format, packed->width) * packed->height;
+  if(!make_room(size, priority))
   {
-    case UP:
-      if(!gtk_tree_path_prev(path))
-        is_valid_path = gtk_tree_path_up(path);
-      else /* row above */
-      {
-        while(gtk_tree_view_row_expanded(treeview, path)) {
-          gtk_tree_model_get_iter(model, &iter, path);
-          /* select last child */
-          gtk_tree_model_iter_nth_child(model, &child_iter, &iter,
-            gtk_tree_model_iter_n_children(model, &iter)-1);
-          gtk_tree_path_free(path);
-          path = gtk_tree_model_get_path(model, &child_iter);
-        }
-      }
-      break;
-    case COLLAPSE:
-      if(!gtk_tree_view_collapse_row(treeview, path)
-        && gtk_tree_path_get_depth(path) > 1)
+    Zathura.Cache.packed       = g_list_prepend(Zathura.Cache.packed, packed);
+    Zathura.Cache.packed_used += packed->length;
+    trim_packed(0);
+
+    Zathura.Cache.packed_misses++;
+    return NULL;
+  }
+
+  cairo_surface_t* surface = create_surface(packed->format, packed->width, packed->height);
+  unsigned char* image     = cairo_image_surface_get_data(surface);
+  int rowstride            = cairo_image_surface_get_stride(surface);
+  int bpp                  = (packed->format == CAIRO_FORMAT_A8) ? 1 : 4;
+  guchar* in               = packed->data;
+
+  int y;
+  for(y = 0; y < packed->height; y++)
+  {
+    unsigned char* row = image + y * rowstride;
+    int x = 0;
+
+    while(x < packed->width)
+    {
+      int count = (*in & 0x7F) + 1;
+
+      if(*in++ & 0x80)
       {
-        gtk_tree_path_up(path);
-        gtk_tree_view_collapse_row(treeview, path);
+        int i;
+        for(i = 0; i < count; i++)
+          memcpy(row + (x + i) * bpp, in, bpp);
+        in += bpp;
       }
-      break;
-    case DOWN:
-      if(gtk_tree_view_row_expanded(treeview, path))
-        gtk_tree_path_down(path);
       else
       {
-        do
-        {
-          gtk_tree_model_get_iter(model, &iter, path);
-          if (gtk_tree_model_iter_next(model, &iter))
-          {
-            path = gtk_tree_model_get_path(model, &iter);
-            break;
-          }
-        }
-        while((is_valid_path = (gtk_tree_path_get_depth(path) > 1))
-          && gtk_tree_path_up(path));
+        memcpy(row + x * bpp, in, count * bpp);
+        in += count * bpp;
       }
-      break;
-    case EXPAND:
-      if(gtk_tree_view_expand_row(treeview, path, FALSE))
-        gtk_tree_path_down(path);
-      break;
-    case SELECT:
-      cb_index_row_activated(treeview, path, NULL, NULL);
-      return;
+
+      x += count;
+    }
   }
 
-  if (is_valid_path)
-    gtk_tree_view_set_cursor(treeview, path, NULL, FALSE);
+  cairo_surface_mark_dirty(surface);
 
-  gtk_tree_path_free(path);
+  Raster* raster = store_raster(page_id, packed->render_scale, priority, surface);
+  Zathura.Cache.packed_hits++;
+  free_packed(packed);
+
+  return raster;
 }
 
-void
-sc_toggle_index(Argument* argument)
+cairo_surface_t*
+get_recording(int page_id, gboolean create)
 {
-  if(!Zathura.PDF.document)
-    return;
-
-  GtkWidget        *treeview;
-  GtkTreeModel     *model;
-  GtkCellRenderer  *renderer;
-  PopplerIndexIter *iter;
-
-  if(!Zathura.UI.index)
+  GList* list;
+  for(list = Zathura.Cache.recordings; list; list = g_list_next(list))
   {
-    Zathura.UI.index = gtk_scrolled_window_new (NULL, NULL);
-    gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(Zathura.UI.index),
-        GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
-
-    if((iter = poppler_index_iter_new(Zathura.PDF.document)))
-    {
-      model = GTK_TREE_MODEL(gtk_tree_store_new(2, G_TYPE_STRING, G_TYPE_POINTER));
-      g_static_mutex_lock(&(Zathura.Lock.pdflib_lock));
-      build_index(model, NULL, iter);
-      g_static_mutex_unlock(&(Zathura.Lock.pdflib_lock));
-      poppler_index_iter_free(iter);
-    }
-    else
+    Recording* recording = (Recording*) list->data;
+    if(recording->page == page_id)
     {
-      notify(WARNING, "This document does not contain any index");
-      Zathura.UI.index = NULL;
-      return;
+      recording->last_used = Zathura.Cache.clock;
+      return recording->surface;
     }
+  }
 
-    treeview = gtk_tree_view_new_with_model (model);
-    g_object_unref(model);
-    renderer = gtk_cell_renderer_text_new();
-    gtk_tree_view_insert_column_with_attributes(GTK_TREE_VIEW (treeview), 0, "Title",
-        renderer, "markup", 0, NULL);
-    gtk_tree_view_set_headers_visible(GTK_TREE_VIEW(treeview), FALSE);
-    g_object_set(G_OBJECT(renderer), "ellipsize", PANGO_ELLIPSIZE_END, NULL);
-    g_object_set(G_OBJECT(gtk_tree_view_get_column(GTK_TREE_VIEW(treeview), 0)), "expand", TRUE, NULL);
+  if(!create || Zathura.Cache.recording_size <= 0 || Zathura.Pressure.active)
+    return NULL;
 
-    gtk_tree_view_set_cursor(GTK_TREE_VIEW(treeview), gtk_tree_path_new_first(), NULL, FALSE);
-    g_signal_connect(G_OBJECT(treeview), "row-activated", G_CALLBACK(cb_index_row_activated), NULL);
+  gsize size = estimate_recording(page_id);
+  if(size > ((gsize) Zathura.Cache.recording_size << 20))
+    return NULL;
 
-    gtk_container_add (GTK_CONTAINER (Zathura.UI.index), treeview);
-    gtk_widget_show (treeview);
-    gtk_widget_show(Zathura.UI.index);
-  }
+  cairo_surface_t* surface = cairo_recording_surface_create(CAIRO_CONTENT_COLOR_ALPHA, NULL);
+  cairo_t* cairo           = cairo_create(surface);
 
-  static gboolean show = FALSE;
-  if(!show)
-  {
-    switch_view(Zathura.UI.index);
-    Zathura.Global.mode = INDEX;
-  }
-  else
-  {
-    switch_view(Zathura.UI.drawing_area);
-    Zathura.Global.mode = NORMAL;
-  }
+  g_static_mutex_lock(&(Zathura.Lock.pdflib_lock));
+  poppler_page_render(Zathura.PDF.pages[page_id]->page, cairo);
+  g_static_mutex_unlock(&(Zathura.Lock.pdflib_lock));
 
-  show = !show;
-}
+  cairo_destroy(cairo);
 
-void
-sc_toggle_inputbar(Argument* argument)
+  trim_recordings(size);
+
+  Recording* recording = malloc(sizeof(Recording));
+  recording->page      = page_id;
+  recording->surface   = surface;
+  recording->size      = size;
+  recording->last_used = Zathura.Cache.clock;
+
+  Zathura.Cache.recordings       = g_list_prepend(Zathura.Cache.recordings, recording);
+  Zathura.Cache.recordings_used += size;
+
+  return surface;
+}
+
+cairo_surface_t*
+replay_page(PopplerPage* page, cairo_surface_t* recording, int scale_level, int rotate)
 {
-  if(GTK_WIDGET_VISIBLE(GTK_WIDGET(Zathura.UI.inputbar)))
-    gtk_widget_hide(GTK_WIDGET(Zathura.UI.inputbar));
+  double page_width, page_height;
+  double width, height;
+
+  double scale = ((double) scale_level / 100.0);
+
+  g_static_mutex_lock(&(Zathura.Lock.pdflib_lock));
+  poppler_page_get_size(page, &page_width, &page_height);
+  g_static_mutex_unlock(&(Zathura.Lock.pdflib_lock));
+
+  if(rotate == 0 || rotate == 180)
+  {
+    width  = page_width  * scale;
+    height = page_height * scale;
+  }
   else
-    gtk_widget_show(GTK_WIDGET(Zathura.UI.inputbar));
+  {
+    width  = page_height * scale;
+    height = page_width  * scale;
+  }
+
+  cairo_surface_t* surface = create_surface(CAIRO_FORMAT_RGB24, width, height);
+  cairo_t* cairo           = cairo_create(surface);
+
+  cairo_set_source_rgb(cairo, 1, 1, 1);
+  cairo_paint(cairo);
+
+  transform_page(cairo, scale, rotate, width, height);
+
+  /* the display list still refers to the fonts of poppler */
+  g_static_mutex_lock(&(Zathura.Lock.pdflib_lock));
+  cairo_set_source_surface(cairo, recording, 0, 0);
+  cairo_paint(cairo);
+  g_static_mutex_unlock(&(Zathura.Lock.pdflib_lock));
+
+  cairo_destroy(cairo);
+
+  return surface;
 }
 
-void
-sc_toggle_statusbar(Argument* argument)
+gsize
+estimate_recording(int page_id)
 {
-  if(GTK_WIDGET_VISIBLE(GTK_WIDGET(Zathura.UI.statusbar)))
-    gtk_widget_hide(GTK_WIDGET(Zathura.UI.statusbar));
-  else
-    gtk_widget_show(GTK_WIDGET(Zathura.UI.statusbar));
+  Page* page = Zathura.PDF.pages[page_id];
+  if(page->recording)
+    return page->recording;
+
+  /* cairo does not tell how large a display list is; most of it are the
+   * decoded images it keeps, which are taken at RECORDING_DPI over the
+   * area they cover, the drawing operations count as a fixed amount and
+   * RECORDING_PAGES bounds what that misses */
+  gsize size = 64 << 10;
+
+  g_static_mutex_lock(&(Zathura.Lock.pdflib_lock));
+  GList* image_list = poppler_page_get_image_mapping(page->page);
+  g_static_mutex_unlock(&(Zathura.Lock.pdflib_lock));
+
+  GList* images;
+  for(images = image_list; images; images = g_list_next(images))
+  {
+    PopplerRectangle* area = &(((PopplerImageMapping*) images->data)->area);
+    double width  = ABS(area->x2 - area->x1) * RECORDING_DPI / 72;
+    double height = ABS(area->y2 - area->y1) * RECORDING_DPI / 72;
+
+    size += (gsize) (width + 1) * (gsize) (height + 1) * 4;
+  }
+
+  poppler_page_free_image_mapping(image_list);
+
+  /* the mapping runs through the whole page, it is only done once */
+  page->recording = size;
+
+  return size;
 }
 
 void
-sc_quit(Argument* argument)
+trim_recordings(gsize size)
 {
-  cb_destroy(NULL, NULL);
+  gsize budget = (gsize) MAX(Zathura.Cache.recording_size, 0) << 20;
+
+  while(Zathura.Cache.recordings && (Zathura.Cache.recordings_used + size > budget ||
+        g_list_length(Zathura.Cache.recordings) >= RECORDING_PAGES))
+  {
+    Recording* victim = NULL;
+
+    GList* list;
+    for(list = Zathura.Cache.recordings; list; list = g_list_next(list))
+    {
+      Recording* recording = (Recording*) list->data;
+      if(!victim || recording->last_used < victim->last_used)
+        victim = recording;
+    }
+
+    Zathura.Cache.recordings       = g_list_remove(Zathura.Cache.recordings, victim);
+    Zathura.Cache.recordings_used -= victim->size;
+
+    cairo_surface_destroy(victim->surface);
+    free(victim);
+  }
 }
 
-/* inputbar shortcut declarations */
 void
-isc_abort(Argument* argument)
+clear_recordings()
 {
-  Argument arg = { HIDE };
-  isc_completion(&arg);
+  GList* list;
+  for(list = Zathura.Cache.recordings; list; list = g_list_next(list))
+  {
+    Recording* recording = (Recording*) list->data;
+    cairo_surface_destroy(recording->surface);
+    free(recording);
+  }
 
-  notify(DEFAULT, "");
-  gtk_widget_grab_focus(GTK_WIDGET(Zathura.UI.view));
+  g_list_free(Zathura.Cache.recordings);
+  Zathura.Cache.recordings      = NULL;
+  Zathura.Cache.recordings_used = 0;
 }
 
 void
-isc_command_history(Argument* argument)
+trim_packed(gsize size)
 {
-  static int current = 0;
-  int        length  = g_list_length(Zathura.Global.history);
+  gsize budget = (gsize) MAX(Zathura.Cache.packed_size, 0) << 20;
 
-  if(length > 0)
+  while(Zathura.Cache.packed && Zathura.Cache.packed_used + size > budget)
   {
-    if(argument->n == NEXT)
-      current = (length + current + 1) % length;
-    else
-      current = (length + current - 1) % length;
+    Packed* victim = NULL;
 
-    gchar* command = (gchar*) g_list_nth_data(Zathura.Global.history, current);
-    notify(DEFAULT, command);
-    gtk_widget_grab_focus(GTK_WIDGET(Zathura.UI.inputbar));
-    gtk_editable_set_position(GTK_EDITABLE(Zathura.UI.inputbar), -1);
+    GList* list;
+    for(list = Zathura.Cache.packed; list; list = g_list_next(list))
+    {
+      Packed* packed = (Packed*) list->data;
+      if(!victim || packed->last_used < victim->last_used)
+        victim = packed;
+    }
+
+    Zathura.Cache.packed       = g_list_remove(Zathura.Cache.packed, victim);
+    Zathura.Cache.packed_used -= victim->length;
+    free_packed(victim);
   }
 }
 
-void 
-isc_completion(Argument* argument)
+void
+free_packed(Packed* packed)
 {
-  gchar *input      = gtk_editable_get_chars(GTK_EDITABLE(Zathura.UI.inputbar), 1, -1);
-  gchar  identifier = gtk_editable_get_chars(GTK_EDITABLE(Zathura.UI.inputbar), 0,  1)[0];
-  int    length     = strlen(input);
- 
-  if(!length && !identifier)
-    return;
+  g_free(packed->data);
+  free(packed);
+}
 
-  /* get current information*/
-  char* first_space = strstr(input, " ");
-  char* current_command;
-  char* current_parameter;
-  int   current_command_length;
-  int   current_parameter_length;
+void
+clear_packed()
+{
+  GList* list;
+  for(list = Zathura.Cache.packed; list; list = g_list_next(list))
+    free_packed((Packed*) list->data);
 
-  if(!first_space)
-  {
-    current_command          = input;
-    current_command_length   = length;
-    current_parameter        = NULL;
-    current_parameter_length = 0;
-  }
-  else
+  g_list_free(Zathura.Cache.packed);
+  Zathura.Cache.packed      = NULL;
+  Zathura.Cache.packed_used = 0;
+}
+
+gboolean
+make_room(gsize size, int priority)
+{
+  gsize budget = (gsize) MAX(Zathura.Cache.size, 0) << 20;
+
+  while(Zathura.Cache.used + size > budget)
   {
-    int offset               = abs(input - first_space);
-    current_command          = g_strndup(input, offset);
-    current_command_length   = strlen(current_command);
-    current_parameter        = input + offset + 1;
-    current_parameter_length = strlen(current_parameter);
-  }
+    /* thumbnails go first, then prefetched pages, then visible ones; a
+     * raster that is on the screen right now is never dropped */
+    Raster* victim = NULL;
 
-  /* if the identifier does not match the command sign and
-   * the completion should not be hidden, leave this function */
-  if((identifier != ':') && (argument->n != HIDE))
-    return;
+    GList* list;
+    for(list = Zathura.Cache.rasters; list; list = g_list_next(list))
+    {
+      Raster* raster = (Raster*) list->data;
 
-  /* static elements */
-  static GtkBox        *results = NULL;
-  static CompletionRow *rows    = NULL;
+      if(raster->priority < priority || cairo_surface_get_reference_count(raster->surface) > 1)
+        continue;
 
-  static int current_item = 0;
-  static int n_items      = 0;
+      if(!victim || raster->priority > victim->priority ||
+          (raster->priority == victim->priority && raster->last_used < victim->last_used))
+        victim = raster;
+    }
 
-  static char *previous_command   = NULL;
-  static char *previous_parameter = NULL;
-  static int   previous_id        = 0;
-  static int   previous_length    = 0;
+    if(!victim)
+      return FALSE;
 
-  static gboolean command_mode = TRUE;
+    Zathura.Cache.rasters = g_list_remove(Zathura.Cache.rasters, victim);
+    pack_raster(victim);
+    free_raster(victim);
+  }
 
-  /* delete old list iff
-   *   the completion should be hidden
-   *   the current command differs from the previous one
-   *   the current parameter differs from the previous one
-   */
-  if( (argument->n == HIDE) ||
-      (current_parameter && previous_parameter && strcmp(current_parameter, previous_parameter)) ||
-      (current_command && previous_command && strcmp(current_command, previous_command)) ||
-      (previous_length != length)
-    )
-  {
-    if(results)
-      gtk_widget_destroy(GTK_WIDGET(results));
+  return TRUE;
+}
 
-    results = NULL;
+void
+free_raster(Raster* raster)
+{
+  Zathura.Cache.used -= raster->size;
+  cairo_surface_destroy(raster->surface);
+  g_list_free(raster->aliases);
+  free(raster);
+}
 
-    if(rows)
-      free(rows);
+void
+clear_rasters()
+{
+  GList* list;
+  for(list = Zathura.Cache.rasters; list; list = g_list_next(list))
+    free_raster((Raster*) list->data);
 
-    rows         = NULL;
-    current_item = 0;
-    n_items      = 0;
-    command_mode = TRUE;
+  g_list_free(Zathura.Cache.rasters);
+  Zathura.Cache.rasters = NULL;
 
-    if(argument->n == HIDE)
-      return;
-  }
+  clear_packed();
+  clear_recordings();
+  g_hash_table_remove_all(Zathura.Cache.rendered);
 
-  /* create new list iff
-   *  there is no current list
-   *  the current command differs from the previous one
-   *  the current parameter differs from the previous one
-   */
-  if( (!results) )
+  if(Zathura.Cache.prefetch)
+    g_source_remove(Zathura.Cache.prefetch);
+  Zathura.Cache.prefetch = 0;
+
+  if(Zathura.Cache.jumps)
+    g_source_remove(Zathura.Cache.jumps);
+  Zathura.Cache.jumps = 0;
+}
+
+void
+drop_rasters(int priority)
+{
+  GList* list = Zathura.Cache.rasters;
+  while(list)
   {
-    results = GTK_BOX(gtk_vbox_new(FALSE, 0));
+    Raster* raster = (Raster*) list->data;
+    GList* next    = g_list_next(list);
 
-    /* create list based on parameters iff
-     *  there is a current parameter given
-     *  there is an old list with commands
-     *  the current command does not differ from the previous one
-     *  the current command has an completion function
-     */
-    if( (previous_command) && (current_parameter) && !strcmp(current_command, previous_command) )
+    if(raster->priority >= priority && cairo_surface_get_reference_count(raster->surface) == 1)
     {
-      if(previous_id < 0 || !commands[previous_id].completion)
-        return;
+      Zathura.Cache.rasters = g_list_delete_link(Zathura.Cache.rasters, list);
+      free_raster(raster);
+    }
 
-      Completion *result = commands[previous_id].completion(current_parameter);
+    list = next;
+  }
+}
 
-      if(!result || !result->groups)
-        return;
+void
+init_pressure()
+{
+  Zathura.Pressure.fd      = -1;
+  Zathura.Pressure.channel = NULL;
+  Zathura.Pressure.watch   = 0;
+  Zathura.Pressure.recover = 0;
+  Zathura.Pressure.active  = FALSE;
+  Zathura.Pressure.level   = 0;
+
+  /* the page cache never takes more than a share of the cgroup limit */
+  gsize limit = cgroup_memory_limit() / CGROUP_SHARE;
+  if(limit && (gsize) Zathura.Cache.size > (limit >> 20))
+    Zathura.Cache.size = MAX(limit >> 20, 1);
+
+  /* the kernel reports a stall above the trigger with POLLPRI */
+  if(g_str_has_prefix(PRESSURE_FILE, "/proc/"))
+    Zathura.Pressure.fd = open(PRESSURE_FILE, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+
+  if(Zathura.Pressure.fd != -1 &&
+      write(Zathura.Pressure.fd, PRESSURE_TRIGGER, strlen(PRESSURE_TRIGGER) + 1) != -1)
+  {
+    Zathura.Pressure.channel = g_io_channel_unix_new(Zathura.Pressure.fd);
+    Zathura.Pressure.watch   = g_io_add_watch(Zathura.Pressure.channel, G_IO_PRI | G_IO_ERR,
+        cb_memory_pressure, NULL);
+    return;
+  }
 
-      command_mode               = FALSE;
-      CompletionGroup* group     = NULL;
-      CompletionElement* element = NULL;
+  if(Zathura.Pressure.fd != -1)
+    close(Zathura.Pressure.fd);
+  Zathura.Pressure.fd = -1;
 
-      rows = malloc(sizeof(CompletionRow));
+  /* kernels without triggers and plain files are polled instead */
+  if(g_file_test(PRESSURE_FILE, G_FILE_TEST_EXISTS))
+    Zathura.Pressure.watch = gdk_threads_add_timeout(PRESSURE_INTERVAL, cb_poll_pressure, NULL);
+}
 
-      for(group = result->groups; group != NULL; group = group->next)
-      {
-        int group_elements = 0;
+void
+shed_memory()
+{
+  Zathura.Pressure.active = TRUE;
 
-        for(element = group->elements; element != NULL; element = element->next)
-        {
-          if( (element->value) &&
-              (current_parameter_length <= strlen(element->value)) && !strncmp(current_parameter, element->value, current_parameter_length)
-            )
-          {
-            rows = realloc(rows, (n_items + 1) * sizeof(CompletionRow));
-            rows[n_items].command     = element->value;
-            rows[n_items].description = element->description;
-            rows[n_items].command_id  = previous_id;
-            rows[n_items].is_group    = FALSE;
-            rows[n_items++].row       = GTK_WIDGET(createCompletionRow(results, element->value, element->description, FALSE));
-            group_elements++;
-          }
-        }
+  /* every signal in a row frees the next, more valuable kind of memory */
+  if(Zathura.Pressure.level < 3)
+    Zathura.Pressure.level++;
 
-        if(group->value && group_elements > 0)
-        {
-          rows = realloc(rows, (n_items + 1) * sizeof(CompletionRow));
-          rows[n_items].command     = group->value;
-          rows[n_items].description = NULL;
-          rows[n_items].command_id  = -1;
-          rows[n_items].is_group    = TRUE;
-          rows[n_items].row       = GTK_WIDGET(createCompletionRow(results, group->value, NULL, TRUE));
+  clear_packed();
+  clear_recordings();
+  drop_rasters(PRIORITY_PREFETCH);
+  clear_pool();
 
-          /* Swap group element with first element of the list */
-          CompletionRow temp = rows[n_items - group_elements];
-          gtk_box_reorder_child(results, rows[n_items].row, n_items - group_elements);
-          rows[n_items - group_elements] = rows[n_items];
-          rows[n_items] = temp;
+  if(Zathura.Pressure.level >= 2)
+    drop_rasters(PRIORITY_VISIBLE);
 
-          n_items++;
-        }
-      }
+  /* pages are loaded again on demand by load_page() */
+  if(Zathura.Pressure.level >= 3 && Zathura.PDF.document && !Zathura.Thread.load_idle)
+  {
+    int i;
+    for(i = 0; i < Zathura.PDF.number_of_pages; i++)
+    {
+      Page* page = Zathura.PDF.pages[i];
+      if(!page || i == Zathura.PDF.page_number)
+        continue;
 
-      /* clean up */
-      group = result->groups;
+      g_static_mutex_lock(&(Zathura.Lock.pdflib_lock));
+      g_object_unref(page->page);
+      g_static_mutex_unlock(&(Zathura.Lock.pdflib_lock));
 
-      while(group)
-      {
-        element = group->elements;
-        while(element)
-        {
-          CompletionElement* ne = element->next;
-          free(element);
-          element = ne;
-        }
-
-        CompletionGroup *ng = group->next;
-        free(group);
-        group = ng;
-      }
+      g_free(page->label);
+      free(page);
+      Zathura.PDF.pages[i] = NULL;
     }
-    /* create list based on commands */
-    else
-    {
-      int i = 0;
-      command_mode = TRUE;
-
-      rows = malloc(LENGTH(commands) * sizeof(CompletionRow));
+  }
 
-      for(i = 0; i < LENGTH(commands); i++)
-      {
-        int abbr_length = commands[i].abbr ? strlen(commands[i].abbr) : 0;
-        int cmd_length  = commands[i].command ? strlen(commands[i].command) : 0;
+  /* hand the freed memory back to the system */
+  malloc_trim(0);
 
-        /* add command to list iff
-         *  the current command would match the command
-         *  the current command would match the abbreviation
-         */
-        if( ((current_command_length <= cmd_length)  && !strncmp(current_command, commands[i].command, current_command_length)) ||
-            ((current_command_length <= abbr_length) && !strncmp(current_command, commands[i].abbr,    current_command_length))
-          )
-        {
-          rows[n_items].command     = commands[i].command;
-          rows[n_items].description = commands[i].description;
-          rows[n_items].command_id  = i;
-          rows[n_items].is_group    = FALSE;
-          rows[n_items++].row       = GTK_WIDGET(createCompletionRow(results, commands[i].command, commands[i].description, FALSE));
-        }
-      }
+  /* back to normal once nothing has been signalled for a while */
+  if(Zathura.Pressure.recover)
+    g_source_remove(Zathura.Pressure.recover);
+  Zathura.Pressure.recover = gdk_threads_add_timeout(PRESSURE_RECOVERY, cb_pressure_relief, NULL);
+}
 
-      rows = realloc(rows, n_items * sizeof(CompletionRow));
-    }
+gsize
+cgroup_memory_limit()
+{
+  char* content = NULL;
+  if(!g_file_get_contents("/proc/self/cgroup", &content, NULL, NULL))
+    return 0;
 
-    gtk_box_pack_start(Zathura.UI.box, GTK_WIDGET(results), FALSE, FALSE, 0);
-    gtk_widget_show_all(GTK_WIDGET(Zathura.UI.window));
+  /* only the unified hierarchy has a single memory.max */
+  char** lines = g_strsplit(content, "\n", -1);
+  char* file   = NULL;
 
-    current_item = (argument->n == NEXT) ? -1 : 0;
+  int i;
+  for(i = 0; lines[i] && !file; i++)
+  {
+    if(g_str_has_prefix(lines[i], "0::"))
+      file = g_build_filename("/sys/fs/cgroup", lines[i] + 3, "memory.max", NULL);
   }
 
-  /* update coloring iff
-   *  there is a list with items
-   */
-  if( (results) && (n_items > 0) )
+  g_strfreev(lines);
+  g_free(content);
+
+  gsize limit = 0;
+  if(file && g_file_get_contents(file, &content, NULL, NULL))
   {
-    setCompletionRowColor(results, NORMAL, current_item);
-    char* temp;
-    int i = 0, next_group = 0;
+    /* "max" means there is no limit */
+    limit = g_ascii_strtoull(content, NULL, 10);
+    g_free(content);
+  }
 
-    for(i = 0; i < n_items; i++)
-    {
-      if(argument->n == NEXT || argument->n == NEXT_GROUP)
-        current_item = (current_item + n_items + 1) % n_items;
-      else if(argument->n == PREVIOUS || argument->n == PREVIOUS_GROUP)
-        current_item = (current_item + n_items - 1) % n_items;
+  g_free(file);
 
-      if(rows[current_item].is_group)
-      {
-        if(!command_mode && (argument->n == NEXT_GROUP || argument->n == PREVIOUS_GROUP))
-          next_group = 1;
-        continue;
-      }
-      else
-      {
-        if(!command_mode && (next_group == 0) && (argument->n == NEXT_GROUP || argument->n == PREVIOUS_GROUP))
-          continue;
-        break;
-      }
-    }
+  return limit;
+}
 
-    setCompletionRowColor(results, HIGHLIGHT, current_item);
+char*
+document_identity(char* file, time_t mtime, off_t size)
+{
+  /* a file that has been changed is another document */
+  char* identity = g_strdup_printf("%s %ld %ld", file, (long) mtime, (long) size);
+  char* checksum = g_compute_checksum_for_string(G_CHECKSUM_SHA1, identity, -1);
+  g_free(identity);
 
-    if(command_mode)
-    {
-      char* cp = (current_parameter) ? g_strconcat(" ", current_parameter, NULL) : 0;
-      temp = g_strconcat(":", rows[current_item].command, cp, NULL);
-    }
-    else
-    {
-      temp = g_strconcat(":", previous_command, " ", rows[current_item].command, NULL);
-    }
+  return checksum;
+}
 
-    gtk_entry_set_text(Zathura.UI.inputbar, temp);
-    gtk_editable_set_position(GTK_EDITABLE(Zathura.UI.inputbar), -1);
-    g_free(temp);
+char*
+disk_raster_path(int page_id, int scale, int rotate, const char* color)
+{
+  char* name = g_strdup_printf("%s-%d-%d-%d-%s", Zathura.Disk.document, page_id, scale, rotate, color);
+  char* path = g_build_filename(Zathura.Disk.directory, name, NULL);
+  g_free(name);
 
-    previous_command   = (command_mode) ? rows[current_item].command : current_command;
-    previous_parameter = (command_mode) ? current_parameter : rows[current_item].command;
-    previous_length    = strlen(previous_command) + ((command_mode) ? (length - current_command_length) : (strlen(previous_parameter) + 1));
-    previous_id        = rows[current_item].command_id;
-  }
+  return path;
 }
 
-void
-isc_string_manipulation(Argument* argument)
+guint32
+raster_checksum(const guchar* data, gsize length)
 {
-  if(argument->n == DELETE_LAST_WORD)
-  {
-    gchar *input  = gtk_editable_get_chars(GTK_EDITABLE(Zathura.UI.inputbar), 0, -1);
-    int    length = strlen(input);
-    int    i      = 0;
-
-    for(i = length; i > 0; i--)
-    {
-      if( (input[i] == ' ') ||
-          (input[i] == '/') )
-      {
-        if(i == (length - 1))
-          continue;
+  /* cairo pads every row to a multiple of four bytes */
+  const guint32* words = (const guint32*) data;
+  guint32 checksum     = 0;
 
-        i = (input[i] == ' ') ? (i - 1) : i;
-        break;
-      }
-    }
+  gsize i;
+  for(i = 0; i < length / 4; i++)
+    checksum = checksum * 31 + words[i];
 
-    notify(DEFAULT, g_strndup(input, i + 1));
-    gtk_editable_set_position(GTK_EDITABLE(Zathura.UI.inputbar), -1);
-  }
+  return checksum;
 }
 
-/* command implementation */
-gboolean
-cmd_bookmark(int argc, char** argv)
+cairo_surface_t*
+map_disk_raster(char* path, int* render_scale)
 {
-  if(!Zathura.PDF.document || argc < 1)
-    return TRUE;
-
-  /* get id */
-  int i;
-  GString *id = g_string_new("");
+  int fd = open(path, O_RDONLY);
+  if(fd == -1)
+    return NULL;
 
-  for(i = 0; i < argc; i++)
+  struct stat information;
+  if(fstat(fd, &information) != 0 || information.st_size < (off_t) sizeof(DiskHeader))
   {
-    if(i != 0)
-      id = g_string_append_c(id, ' ');
-
-    id = g_string_append(id, argv[i]);
+    close(fd);
+    return NULL;
   }
 
-  /* check for existing bookmark to overwrite */
-  for(i = 0; i < Zathura.Bookmarks.number_of_bookmarks; i++)
+  /* the pixels are used where they are, private pages keep cairo from
+   * writing through to the file */
+  char* data = mmap(NULL, information.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+
+  if(data == MAP_FAILED)
+    return NULL;
+
+  Mapping* mapping = malloc(sizeof(Mapping));
+  mapping->data    = data;
+  mapping->length  = information.st_size;
+  mapping->mapped  = TRUE;
+
+  DiskHeader* header = (DiskHeader*) data;
+  guchar* image      = (guchar*) data + sizeof(DiskHeader);
+
+  /* files that were cut short, damaged or written by another version are removed */
+  if(memcmp(header->magic, DISK_MAGIC, sizeof(header->magic)) ||
+      (header->format != CAIRO_FORMAT_RGB24 && header->format != CAIRO_FORMAT_A8) ||
+      header->width < 1 || header->width > 32767 || header->height < 1 || header->height > 32767 ||
+      (int) header->stride != cairo_format_stride_for_width(header->format, header->width) ||
+      header->length != (guint64) header->stride * header->height ||
+      header->length != mapping->length - sizeof(DiskHeader) ||
+      raster_checksum(image, header->length) != header->checksum)
   {
-    if(!strcmp(id->str, Zathura.Bookmarks.bookmarks[i].id))
-    {
-      Zathura.Bookmarks.bookmarks[i].page = Zathura.PDF.page_number;
-      return TRUE;
-    }
+    unmap_file(mapping);
+    unlink(path);
+    return NULL;
   }
 
-  /* add new bookmark */
-  Zathura.Bookmarks.bookmarks = realloc(Zathura.Bookmarks.bookmarks, 
-      (Zathura.Bookmarks.number_of_bookmarks + 1) * sizeof(Bookmark)); 
+  cairo_surface_t* surface = cairo_image_surface_create_for_data(image, header->format,
+      header->width, header->height, header->stride);
+  cairo_surface_set_user_data(surface, &(Zathura.Disk.key), mapping, (cairo_destroy_func_t) unmap_file);
 
-  Zathura.Bookmarks.bookmarks[Zathura.Bookmarks.number_of_bookmarks].id   = id->str;
-  Zathura.Bookmarks.bookmarks[Zathura.Bookmarks.number_of_bookmarks].page = Zathura.PDF.page_number;
-  Zathura.Bookmarks.number_of_bookmarks++;
+  *render_scale = header->render_scale;
 
-  return TRUE;
+  /* the modification time orders the files for eviction */
+  utime(path, NULL);
+
+  return surface;
 }
 
-gboolean
-cmd_open_bookmark(int argc, char** argv)
+cairo_surface_t*
+find_disk_raster(int page_id, int scale, int rotate, int* render_scale)
 {
-  if(!Zathura.PDF.document || argc < 1)
-    return TRUE;
-  
-  /* get id */
-  int i;
-  GString *id = g_string_new("");
+  if(!Zathura.Disk.document || Zathura.Disk.size <= 0)
+    return NULL;
 
-  for(i = 0; i < argc; i++)
-  {
-    if(i != 0)
-      id = g_string_append_c(id, ' ');
+  char* path = disk_raster_path(page_id, scale, rotate, Zathura.Global.recolor ? "recolor" : "color");
+  cairo_surface_t* surface = map_disk_raster(path, render_scale);
+  g_free(path);
 
-    id = g_string_append(id, argv[i]);
+  /* gray pages are recolored when they are painted */
+  if(!surface)
+  {
+    path    = disk_raster_path(page_id, scale, rotate, "gray");
+    surface = map_disk_raster(path, render_scale);
+    g_free(path);
   }
 
-  /* find bookmark */
-  for(i = 0; i < Zathura.Bookmarks.number_of_bookmarks; i++)
+  return surface;
+}
+
+Raster*
+load_disk_raster(int page_id, int priority)
+{
+  int render_scale;
+  cairo_surface_t* surface = find_disk_raster(page_id, Zathura.PDF.scale, Zathura.PDF.rotate, &render_scale);
+  if(!surface)
+    return NULL;
+
+  gsize size = (gsize) cairo_image_surface_get_stride(surface) * cairo_image_surface_get_height(surface);
+  if(!make_room(size, priority))
   {
-    if(!strcmp(id->str, Zathura.Bookmarks.bookmarks[i].id))
-    {
-      set_page(Zathura.Bookmarks.bookmarks[i].page);
-      return TRUE;
-    }
+    cairo_surface_destroy(surface);
+    return NULL;
   }
 
-  notify(WARNING, "No matching bookmark found");
-  return FALSE;
+  Zathura.Disk.hits++;
+
+  return store_raster(page_id, render_scale, priority, surface);
 }
 
-gboolean
-cmd_close(int argc, char** argv)
+void
+save_disk_raster(int page_id, int render_scale, cairo_surface_t* surface)
 {
-  if(!Zathura.PDF.document)
+  /* pages that did not fit into the memory budget are not worth keeping */
+  if(!Zathura.Disk.document || Zathura.Disk.size <= 0 || render_scale != Zathura.PDF.scale)
+    return;
+
+  const char* color = (cairo_image_surface_get_format(surface) == CAIRO_FORMAT_A8) ? "gray" :
+    (Zathura.Global.recolor ? "recolor" : "color");
+
+  /* cached rasters are not changed anymore, so the worker can read it meanwhile */
+  DiskRaster* raster   = malloc(sizeof(DiskRaster));
+  raster->path         = disk_raster_path(page_id, Zathura.PDF.scale, Zathura.PDF.rotate, color);
+  raster->render_scale = render_scale;
+  raster->surface      = cairo_surface_reference(surface);
+
+  if(!push_job(write_disk_raster, raster, PRIORITY_BACKGROUND, NULL, NULL))
+    write_disk_raster(raster);
+}
+
+void
+trim_disk_cache(gsize size)
+{
+  gsize budget = (gsize) MAX(Zathura.Disk.size, 0) << 20;
+
+  /* rasters are written by several workers */
+  g_static_mutex_lock(&(Zathura.Disk.lock));
+
+  /* the directory is only read when it might have grown beyond the budget */
+  if(Zathura.Disk.counted)
   {
-    if(argc != -1)
-      notify(ERROR, "No file has been opened");
-    return FALSE;
+    Zathura.Disk.used += size;
+    if(Zathura.Disk.used <= budget)
+    {
+      g_static_mutex_unlock(&(Zathura.Disk.lock));
+      return;
+    }
   }
 
-  /* clean up pages */
-  int i;
-  for(i = 0; i < Zathura.PDF.number_of_pages; i++)
+  GDir* directory = g_dir_open(Zathura.Disk.directory, 0, NULL);
+  if(!directory)
   {
-    Page* current_page = Zathura.PDF.pages[i];
-    g_object_unref(current_page->page);
+    g_static_mutex_unlock(&(Zathura.Disk.lock));
+    return;
   }
 
-  /* save bookmarks */
-  if(Zathura.Bookmarks.data)
+  /* the directory is read once, the files are removed from the least
+   * recently used on until a tenth of the budget is free */
+  GList* files = NULL;
+  gsize used   = 0;
+
+  const char* name;
+  while((name = g_dir_read_name(directory)))
   {
-    /* set current page */
-    g_key_file_set_integer(Zathura.Bookmarks.data, Zathura.PDF.file,
-        BM_PAGE_ENTRY, Zathura.PDF.page_number);
+    char* path = g_build_filename(Zathura.Disk.directory, name, NULL);
 
-    /* set page offset */
-    g_key_file_set_integer(Zathura.Bookmarks.data, Zathura.PDF.file,
-        BM_PAGE_OFFSET, Zathura.PDF.page_offset);
+    struct stat information;
+    if(stat(path, &information) != 0 || !S_ISREG(information.st_mode))
+    {
+      g_free(path);
+      continue;
+    }
 
-    /* save bookmarks */
-    int i;
-    for(i = 0; i < Zathura.Bookmarks.number_of_bookmarks; i++)
-      g_key_file_set_integer(Zathura.Bookmarks.data, Zathura.PDF.file,
-          Zathura.Bookmarks.bookmarks[i].id, Zathura.Bookmarks.bookmarks[i].page);
+    DiskFile* file = malloc(sizeof(DiskFile));
+    file->path     = path;
+    file->mtime    = information.st_mtime;
+    file->size     = information.st_size;
 
-    /* convert file and save it */
-    gchar* bookmarks = g_key_file_to_data(Zathura.Bookmarks.data, NULL, NULL);
-    g_file_set_contents(Zathura.Bookmarks.file, bookmarks, -1, NULL);
-    g_free(bookmarks);
+    files = g_list_prepend(files, file);
+    used += file->size;
   }
 
-  /* inotify */
-  if(Zathura.Inotify.fd != -1 && Zathura.Inotify.wd != -1)
-    inotify_rm_watch(Zathura.Inotify.fd, Zathura.Inotify.wd);
-
-  Zathura.Inotify.wd = -1;
-
-  /* reset values */
-  free(Zathura.PDF.pages);
-  g_object_unref(Zathura.PDF.document);
-
-  Zathura.State.pages         = "";
-  Zathura.State.filename      = (char*) DEFAULT_TEXT;
+  g_dir_close(directory);
 
-  g_static_mutex_lock(&(Zathura.Lock.document_lock));
-  Zathura.PDF.document        = NULL;
-  g_static_mutex_unlock(&(Zathura.Lock.document_lock));
-  Zathura.PDF.file            = "";
-  Zathura.PDF.password        = "";
-  Zathura.PDF.page_number     = 0;
-  Zathura.PDF.number_of_pages = 0;
-  Zathura.PDF.scale           = 0;
-  Zathura.PDF.rotate          = 0;
-  Zathura.PDF.page_offset     = 0;
+  files = g_list_sort(files, compare_disk_files);
 
-  /* destroy index */
-  if(Zathura.UI.index)
+  GList* list;
+  for(list = files; list; list = g_list_next(list))
   {
-    gtk_widget_destroy(Zathura.UI.index);
-    Zathura.UI.index = NULL;
-  }
+    DiskFile* file = (DiskFile*) list->data;
 
-  /* destroy information */
-  if(Zathura.UI.information)
-  {
-    gtk_widget_destroy(Zathura.UI.information);
-    Zathura.UI.information = NULL;
+    if(used > budget / 10 * 9 && unlink(file->path) == 0)
+      used -= file->size;
+
+    g_free(file->path);
+    free(file);
   }
 
-  /* free markers */
-  if(Zathura.Marker.markers)
-    free(Zathura.Marker.markers);
-  Zathura.Marker.number_of_markers =  0;
-  Zathura.Marker.last              = -1;
+  g_list_free(files);
 
-  update_status();
+  Zathura.Disk.used    = used;
+  Zathura.Disk.counted = TRUE;
 
-  return TRUE;
+  g_static_mutex_unlock(&(Zathura.Disk.lock));
 }
 
-gboolean
-cmd_correct_offset(int argc, char** argv)
+gint
+compare_disk_files(gconstpointer a, gconstpointer b)
 {
-  if(!Zathura.PDF.document || argc == 0)
-    return TRUE;
+  const DiskFile* first  = (const DiskFile*) a;
+  const DiskFile* second = (const DiskFile*) b;
 
-  Zathura.PDF.page_offset = (Zathura.PDF.page_number + 1) - atoi(argv[0]);
+  return (first->mtime > second->mtime) - (first->mtime < second->mtime);
+}
 
-  if(Zathura.PDF.page_offset != 0)
-    Zathura.Global.goto_mode = GOTO_OFFSET;
-  else
-    Zathura.Global.goto_mode = GOTO_MODE;
+void
+detach_surface(int page_id)
+{
+  /* highlights are drawn on a copy of the shown page, so the cached
+   * raster stays clean */
+  cairo_surface_t** shown = page_surface(page_id);
+  if(!*shown || (cairo_surface_get_reference_count(*shown) == 1 &&
+        cairo_image_surface_get_format(*shown) != CAIRO_FORMAT_A8))
+    return;
 
-  update_status();
+  double width, height;
+  get_page_size(page_id, &width, &height);
 
-  return TRUE;
+  cairo_surface_t* surface = create_surface(CAIRO_FORMAT_RGB24, width, height);
+  cairo_t* cairo = cairo_create(surface);
+
+  cairo_scale(cairo, (int) width / (double) cairo_image_surface_get_width(*shown),
+      (int) height / (double) cairo_image_surface_get_height(*shown));
+  paint_surface(cairo, *shown);
+  cairo_destroy(cairo);
+
+  cairo_surface_destroy(*shown);
+  *shown = surface;
+  invalidate_pixmap();
 }
 
-gboolean
-cmd_delete_bookmark(int argc, char** argv)
+void
+invalidate_pixmap()
 {
-  if(!Zathura.PDF.document || argc < 1)
-    return TRUE;
+  /* the raster is uploaded again on the next expose */
+  if(Zathura.PDF.pixmap)
+    g_object_unref(Zathura.PDF.pixmap);
+  Zathura.PDF.pixmap = NULL;
+}
 
-  /* get id */
-  int i;
-  GString *id = g_string_new("");
+cairo_surface_t*
+gray_surface(cairo_surface_t* surface)
+{
+  unsigned char* image = cairo_image_surface_get_data(surface);
+  int x, y;
 
-  for(i = 0; i < argc; i++)
+  int width     = cairo_image_surface_get_width(surface);
+  int height    = cairo_image_surface_get_height(surface);
+  int rowstride = cairo_image_surface_get_stride(surface);
+
+  cairo_surface_flush(surface);
+
+  for(y = 0; y < height; y++)
   {
-    if(i != 0)
-      id = g_string_append_c(id, ' ');
+    guint32* data = (guint32*) (image + y * rowstride);
 
-    id = g_string_append(id, argv[i]);
+    for(x = 0; x < width; x++)
+    {
+      guint32 pixel = data[x];
+      if(((pixel >> 16) & 0xFF) != (pixel & 0xFF) || ((pixel >> 8) & 0xFF) != (pixel & 0xFF))
+        return NULL;
+    }
   }
 
-  /* check for bookmark to delete */
-  for(i = 0; i < Zathura.Bookmarks.number_of_bookmarks; i++)
+  /* one byte of ink per pixel instead of four bytes of color */
+  cairo_surface_t* gray = create_surface(CAIRO_FORMAT_A8, width, height);
+  unsigned char* gray_image = cairo_image_surface_get_data(gray);
+  int gray_rowstride        = cairo_image_surface_get_stride(gray);
+
+  for(y = 0; y < height; y++)
   {
-    if(!strcmp(id->str, Zathura.Bookmarks.bookmarks[i].id))
-    {
-      /* update key file */
-      g_key_file_remove_key(Zathura.Bookmarks.data, Zathura.PDF.file, Zathura.Bookmarks.bookmarks[i].id, NULL);
+    guint32* data       = (guint32*) (image + y * rowstride);
+    unsigned char* ink  = gray_image + y * gray_rowstride;
 
-      /* update bookmarks */
-      Zathura.Bookmarks.bookmarks[i].id   = Zathura.Bookmarks.bookmarks[Zathura.Bookmarks.number_of_bookmarks - 1].id;
-      Zathura.Bookmarks.bookmarks[i].page = Zathura.Bookmarks.bookmarks[Zathura.Bookmarks.number_of_bookmarks - 1].page;
-      Zathura.Bookmarks.bookmarks = realloc(Zathura.Bookmarks.bookmarks,
-          Zathura.Bookmarks.number_of_bookmarks * sizeof(Bookmark));
+    for(x = 0; x < width; x++)
+      ink[x] = 0xFF - (data[x] & 0xFF);
+  }
 
-      Zathura.Bookmarks.number_of_bookmarks--;
+  cairo_surface_mark_dirty(gray);
 
-      return TRUE;
-    }
+  return gray;
+}
+
+void
+paint_surface(cairo_t* cairo, cairo_surface_t* surface)
+{
+  if(cairo_image_surface_get_format(surface) != CAIRO_FORMAT_A8)
+  {
+    cairo_set_source_surface(cairo, surface, 0, 0);
+    cairo_paint(cairo);
+    return;
   }
 
-  return TRUE;
+  /* the ink is laid over the paper, which gives the same colors as
+   * recolor_surface() does for gray pixels */
+  GdkColor* paper = &(Zathura.Style.recolor_lightcolor);
+  GdkColor* ink   = &(Zathura.Style.recolor_darkcolor);
+
+  if(Zathura.Global.recolor)
+    cairo_set_source_rgb(cairo, paper->red / 65535.0, paper->green / 65535.0, paper->blue / 65535.0);
+  else
+    cairo_set_source_rgb(cairo, 1, 1, 1);
+
+  cairo_rectangle(cairo, 0, 0, cairo_image_surface_get_width(surface), cairo_image_surface_get_height(surface));
+  cairo_fill(cairo);
+
+  if(Zathura.Global.recolor)
+    cairo_set_source_rgb(cairo, ink->red / 65535.0, ink->green / 65535.0, ink->blue / 65535.0);
+  else
+    cairo_set_source_rgb(cairo, 0, 0, 0);
+
+  cairo_mask_surface(cairo, surface, 0, 0);
 }
 
-gboolean
-cmd_export(int argc, char** argv)
+void
+change_mode(int mode)
 {
-  if(argc == 0 || !Zathura.PDF.document)
-    return TRUE;
+  char* mode_text;
 
-  if(argc < 2)
+  switch(mode)
   {
-    notify(WARNING, "No export path specified");
-    return FALSE;
+    case INSERT:
+      mode_text = "-- INSERT --";
+      break;
+    case VISUAL:
+      mode_text = "-- VISUAL --";
+      break;
+    case ADD_MARKER:
+      mode_text = "";
+      break;
+    case EVAL_MARKER:
+      mode_text = "";
+      break;
+    default:
+      mode_text = "";
+      mode      = NORMAL;
+      break;
   }
 
-  /* export images */
-  if(!strcmp(argv[0], "images"))
+  Zathura.Global.mode = mode;
+  notify(DEFAULT, mode_text);
+}
+
+void
+eval_marker(int id)
+{
+  /* go to last marker */
+  if(id == 0x27)
   {
-    int page_number;
-    for(page_number = 0; page_number < Zathura.PDF.number_of_pages; page_number++)
+    int current_page = Zathura.PDF.page_number;
+    set_page(Zathura.Marker.last);
+    Zathura.Marker.last = current_page;
+    return;
+  }
+
+  /* search markers */
+  int i;
+  for(i = 0; i < Zathura.Marker.number_of_markers; i++)
+  {
+    if(Zathura.Marker.markers[i].id == id)
     {
-      GList           *image_list;
-      GList           *images;
-      cairo_surface_t *image;
+      set_page(Zathura.Marker.markers[i].page);
+      return;
+    }
+  }
+}
 
-      g_static_mutex_lock(&(Zathura.Lock.pdflib_lock));
-      image_list = poppler_page_get_image_mapping(Zathura.PDF.pages[page_number]->page);
-      g_static_mutex_unlock(&(Zathura.Lock.pdflib_lock));
+void
+highlight_result(int page_id, PopplerRectangle* rectangle)
+{
+  detach_surface(page_id);
 
-      if(!g_list_length(image_list))
-      {
-        notify(WARNING, "This document does not contain any images");
-        return FALSE;
-      }
+  cairo_t *cairo = cairo_create(*page_surface(page_id));
+  cairo_set_source_rgba(cairo, Zathura.Style.search_highlight.red, Zathura.Style.search_highlight.green,
+      Zathura.Style.search_highlight.blue, TRANSPARENCY);
 
-      for(images = image_list; images; images = g_list_next(images))
-      {
-        PopplerImageMapping *image_mapping;
-        PopplerRectangle     image_field;
-        gint                 image_id;
-        char*                file;
-        char*                filename;
+  recalcRectangle(page_id, rectangle);
+  cairo_rectangle(cairo, rectangle->x1, rectangle->y1, (rectangle->x2 - rectangle->x1), (rectangle->y2 - rectangle->y1));
+  cairo_fill(cairo);
 
-        image_mapping = (PopplerImageMapping*) images->data;
-        image_field   = image_mapping->area;
-        image_id      = image_mapping->image_id;
+  invalidate_pixmap();
+}
 
-        g_static_mutex_lock(&(Zathura.Lock.pdflib_lock));
-        image     = poppler_page_get_image(Zathura.PDF.pages[page_number]->page, image_id);
-        g_static_mutex_unlock(&(Zathura.Lock.pdflib_lock));
+Mapping*
+map_file(char* file)
+{
+  int fd = open(file, O_RDONLY);
+  if(fd == -1)
+    return NULL;
 
-        if(!image)
-          continue;
+  /* poppler addresses the data with an int */
+  struct stat information;
+  if(fstat(fd, &information) == -1 || information.st_size <= 0 || information.st_size > G_MAXINT)
+  {
+    close(fd);
+    return NULL;
+  }
 
-        filename  = g_strdup_printf("%s_p%i_i%i.png", Zathura.PDF.file, page_number + 1, image_id);
+  gsize length    = information.st_size;
+  gsize page_size = sysconf(_SC_PAGESIZE);
+  gsize tail      = (length > READAHEAD_SIZE) ? ((length - READAHEAD_SIZE) & ~(page_size - 1)) : 0;
 
-        if(argv[1][0] == '~')
-        {
-          file = malloc(((int) strlen(filename) + (int) strlen(argv[1]) 
-            + (int) strlen(getenv("HOME")) - 1) * sizeof(char));
-          file = g_strdup_printf("%s%s%s", getenv("HOME"), argv[1] + 1, filename);
-        }
-        else
-          file = g_strdup_printf("%s%s", argv[1], filename);
+  /* poppler reads the trailer and the xref table at the end of the file
+   * first, then the header (and the first page of linearized files) and
+   * afterwards the pages in random order */
+  posix_fadvise(fd, 0, 0, POSIX_FADV_RANDOM);
+  posix_fadvise(fd, tail, 0, POSIX_FADV_WILLNEED);
+  posix_fadvise(fd, 0, MIN(length, READAHEAD_SIZE), POSIX_FADV_WILLNEED);
 
-        cairo_surface_write_to_png(image, file);
+  char* data = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
 
-        g_free(file);
-      }
-    }
-  }
-  else if(!strcmp(argv[0], "attachments"))
-  {
-    g_static_mutex_lock(&(Zathura.Lock.pdflib_lock));
-    if(!poppler_document_has_attachments(Zathura.PDF.document))
-    {
-      notify(WARNING, "PDF file has no attachments");
-      g_static_mutex_unlock(&(Zathura.Lock.pdflib_lock));
-      return FALSE;
-    }
+  if(data == MAP_FAILED)
+    return NULL;
 
-    GList *attachment_list = poppler_document_get_attachments(Zathura.PDF.document);
-    g_static_mutex_unlock(&(Zathura.Lock.pdflib_lock));
+  madvise(data, length, MADV_RANDOM);
+  madvise(data + tail, length - tail, MADV_WILLNEED);
+  madvise(data, MIN(length, READAHEAD_SIZE), MADV_WILLNEED);
 
-    GList *attachments;
-    char  *file;
+  Mapping* mapping = malloc(sizeof(Mapping));
+  mapping->data    = data;
+  mapping->length  = length;
+  mapping->mapped  = TRUE;
 
-    for(attachments = attachment_list; attachments; attachments = g_list_next(attachments))
+  return mapping;
+}
+
+Mapping*
+map_stream(int fd)
+{
+  /* the data is collected in an anonymous memory file, or in a plain
+   * buffer if the kernel does not support those */
+  int memory = -1;
+#ifdef MFD_CLOEXEC
+  memory = memfd_create("zathura", MFD_CLOEXEC);
+#endif
+
+  GByteArray* buffer = (memory == -1) ? g_byte_array_new() : NULL;
+  gboolean    failed = FALSE;
+  gsize       length = 0;
+  char        chunk[65536];
+  ssize_t     count;
+
+  while(!failed && (count = read(fd, chunk, sizeof(chunk))) != 0)
+  {
+    if(count < 0)
     {
-      PopplerAttachment *attachment = (PopplerAttachment*) attachments->data;
+      failed = (errno != EINTR);
+      continue;
+    }
 
-      if(argv[1][0] == '~')
+    if(buffer)
+      g_byte_array_append(buffer, (guint8*) chunk, count);
+    else
+    {
+      ssize_t written = 0;
+      while(!failed && written < count)
       {
-        file = malloc(((int) strlen(attachment->name) + (int) strlen(argv[1])
-          + (int) strlen(getenv("HOME")) - 1) * sizeof(char));
-        file = g_strdup_printf("%s%s%s", getenv("HOME"), argv[1] + 1, attachment->name);
+        ssize_t result = write(memory, chunk + written, count - written);
+        if(result < 0)
+          failed = (errno != EINTR);
+        else
+          written += result;
       }
-      else
-        file = g_strdup_printf("%s%s", argv[1], attachment->name);
+    }
 
-      g_static_mutex_lock(&(Zathura.Lock.pdflib_lock));
-      poppler_attachment_save(attachment, file, NULL);
-      g_static_mutex_unlock(&(Zathura.Lock.pdflib_lock));
+    length += count;
+  }
 
-      g_free(file);
+  /* poppler addresses the data with an int */
+  if(length == 0 || length > G_MAXINT)
+    failed = TRUE;
+
+  Mapping* mapping = NULL;
+
+  if(!failed && buffer)
+  {
+    mapping         = malloc(sizeof(Mapping));
+    mapping->data   = (char*) g_byte_array_free(buffer, FALSE);
+    mapping->length = length;
+    mapping->mapped = FALSE;
+  }
+  else if(!failed)
+  {
+    char* data = mmap(NULL, length, PROT_READ, MAP_PRIVATE, memory, 0);
+    if(data != MAP_FAILED)
+    {
+      madvise(data, length, MADV_RANDOM);
+
+      mapping         = malloc(sizeof(Mapping));
+      mapping->data   = data;
+      mapping->length = length;
+      mapping->mapped = TRUE;
     }
   }
+  else if(buffer)
+    g_byte_array_free(buffer, TRUE);
 
-  return TRUE;
+  if(memory != -1)
+    close(memory);
+
+  return mapping;
 }
 
-gboolean
-cmd_info(int argc, char** argv)
+void
+unmap_file(Mapping* mapping)
 {
-  if(!Zathura.PDF.document)
-    return TRUE;
+  if(!mapping)
+    return;
 
-  static gboolean visible = FALSE;
+  if(mapping->mapped)
+    munmap(mapping->data, mapping->length);
+  else
+    g_free(mapping->data);
 
-  if(!Zathura.UI.information)
+  free(mapping);
+}
+
+void notify(int level, char* message)
+{
+  switch(level)
   {
-    GtkListStore      *list;
-    GtkTreeIter        iter;
-    GtkCellRenderer   *renderer;
-    GtkTreeSelection  *selection;
+    case ERROR:
+      gtk_widget_modify_base(GTK_WIDGET(Zathura.UI.inputbar), GTK_STATE_NORMAL, &(Zathura.Style.notification_e_bg));
+      gtk_widget_modify_text(GTK_WIDGET(Zathura.UI.inputbar), GTK_STATE_NORMAL, &(Zathura.Style.notification_e_fg));
+      break;
+    case WARNING:
+      gtk_widget_modify_base(GTK_WIDGET(Zathura.UI.inputbar), GTK_STATE_NORMAL, &(Zathura.Style.notification_w_bg));
+      gtk_widget_modify_text(GTK_WIDGET(Zathura.UI.inputbar), GTK_STATE_NORMAL, &(Zathura.Style.notification_w_fg));
+      break;
+    default:
+      gtk_widget_modify_base(GTK_WIDGET(Zathura.UI.inputbar), GTK_STATE_NORMAL, &(Zathura.Style.inputbar_bg));
+      gtk_widget_modify_text(GTK_WIDGET(Zathura.UI.inputbar), GTK_STATE_NORMAL, &(Zathura.Style.inputbar_fg));
+      break;
+  }
+ 
+  if(message)
+    gtk_entry_set_text(Zathura.UI.inputbar, message);
+}
 
-    list = gtk_list_store_new(2, G_TYPE_STRING, G_TYPE_STRING);
+gboolean
+open_file(char* path, char* password)
+{
+  /* get filename, "-" stands for the standard input */
+  gboolean input = !strcmp(path, "-");
+  char* file     = input ? strdup(path) : realpath(path, NULL);
+
+  if(path[0] == '~')
+  {
+    char* home_path = getenv("HOME");
+    int file_len = strlen(home_path) + strlen(path) - 1;
+    file = malloc(file_len);
+    snprintf(file, file_len, "%s%s", getenv("HOME"), path + 1);
+  }
+
+  /* check if file exists */
+  if(!input && (!file || !g_file_test(file, G_FILE_TEST_IS_REGULAR)))
+  {
+    notify(ERROR, "File does not exist");
+    free(file);
+    return FALSE;
+  }
+
+  /* close old file */
+  cmd_close(-1, NULL);
+
+  /* check saved password */
+  if(!password)
+    password = (Zathura.PDF.password && strlen(Zathura.PDF.password) != 0) ? Zathura.PDF.password : NULL;
+
+  /* bookmarks, a document from the standard input has no identity */
+  clear_bookmarks();
+  if(!input)
+  {
+    load_bookmarks(file);
+    load_costs(file);
+  }
+
+  /* page offset and bookmarks */
+  if(Zathura.Bookmarks.data && g_key_file_has_group(Zathura.Bookmarks.data, file))
+  {
+    /* get page offset */
+    if(g_key_file_has_key(Zathura.Bookmarks.data, file, BM_PAGE_OFFSET, NULL))
+      Zathura.PDF.page_offset = g_key_file_get_integer(Zathura.Bookmarks.data, file, BM_PAGE_OFFSET, NULL);
+    if((Zathura.PDF.page_offset != 0) && (Zathura.PDF.page_offset != GOTO_OFFSET))
+      Zathura.PDF.page_offset = GOTO_OFFSET;
+
+    /* open and read bookmark file */
+    gsize i              = 0;
+    gsize number_of_keys = 0;
+    char** keys          = g_key_file_get_keys(Zathura.Bookmarks.data, file, &number_of_keys, NULL);
+
+    for(i = 0; i < number_of_keys; i++)
+    {
+      if(strcmp(keys[i], BM_PAGE_ENTRY) && strcmp(keys[i], BM_PAGE_OFFSET))
+      {
+        Zathura.Bookmarks.bookmarks = realloc(Zathura.Bookmarks.bookmarks, 
+            (Zathura.Bookmarks.number_of_bookmarks + 1) * sizeof(Bookmark)); 
+
+        Zathura.Bookmarks.bookmarks[Zathura.Bookmarks.number_of_bookmarks].id   = keys[i];
+        Zathura.Bookmarks.bookmarks[Zathura.Bookmarks.number_of_bookmarks].page = 
+          g_key_file_get_integer(Zathura.Bookmarks.data, file, keys[i], NULL);
+
+        Zathura.Bookmarks.number_of_bookmarks++;
+      }
+      else
+        g_free(keys[i]);
+    }
+
+    g_free(keys);
+  }
+
+  /* start page */
+  int start_page = 0;
+
+  if(Zathura.Bookmarks.data && g_key_file_has_key(Zathura.Bookmarks.data, file, BM_PAGE_ENTRY, NULL))
+    start_page = g_key_file_get_integer(Zathura.Bookmarks.data, file, BM_PAGE_ENTRY, NULL);
+
+  /* show loading state while the document is parsed in the background */
+  Zathura.PDF.scale      = 100;
+  Zathura.PDF.rotate     = 0;
+  Zathura.State.filename = g_markup_escape_text(file, -1);
+  Zathura.State.pages    = "[Loading...]";
+  Zathura.State.loading  = TRUE;
+  update_status();
+
+  /* the page that was shown last is mapped from the disk right away */
+  struct stat information;
+  if(!input && !Zathura.Global.stream && stat(file, &information) == 0)
+  {
+    Zathura.Disk.document = document_identity(file, information.st_mtime, information.st_size);
+
+    char* name = g_strconcat(Zathura.Disk.document, ".last", NULL);
+    char* last = g_build_filename(Zathura.Disk.directory, name, NULL);
+    char* view = NULL;
+    int page_id, scale, rotate, render_scale;
+
+    if(!Zathura.Global.spread && g_file_get_contents(last, &view, NULL, NULL) &&
+        sscanf(view, "%d %d %d", &page_id, &scale, &rotate) == 3 && page_id == start_page && scale > 0 &&
+        (Zathura.PDF.surface = find_disk_raster(page_id, scale, rotate, &render_scale)))
+    {
+      Zathura.PDF.scale  = scale;
+      Zathura.PDF.rotate = rotate;
+
+      gtk_widget_set_size_request(Zathura.UI.drawing_area, cairo_image_surface_get_width(Zathura.PDF.surface),
+          cairo_image_surface_get_height(Zathura.PDF.surface));
+      gtk_widget_queue_draw(Zathura.UI.drawing_area);
+    }
+
+    g_free(view);
+    g_free(last);
+    g_free(name);
+  }
+
+  /* a streamed file is followed as it grows */
+  if(Zathura.Global.stream && !input)
+  {
+    Zathura.Stream.file     = g_strdup(file);
+    Zathura.Stream.password = password ? g_strdup(password) : NULL;
+    Zathura.Stream.size     = 0;
+  }
+
+  /* inotify */
+  if(Zathura.Inotify.fd != -1 && !input)
+    Zathura.Inotify.wd = inotify_add_watch(Zathura.Inotify.fd, file,
+        IN_CLOSE_WRITE | (Zathura.Stream.file ? IN_MODIFY : 0));
+
+  start_loader(file, password, start_page, FALSE);
+  free(file);
+
+  return TRUE;
+}
+
+void
+load_bookmarks(char* file)
+{
+  /* the journal is named after the checksum of the document path */
+  char* checksum = g_compute_checksum_for_string(G_CHECKSUM_SHA1, file, -1);
+
+  Zathura.Bookmarks.file    = g_build_filename(Zathura.Bookmarks.directory, checksum, NULL);
+  Zathura.Bookmarks.data    = g_key_file_new();
+  Zathura.Bookmarks.records = 0;
+  g_free(checksum);
+
+  char* content = NULL;
+  if(!g_file_get_contents(Zathura.Bookmarks.file, &content, NULL, NULL))
+    return;
+
+  /* replay the journal, later records override earlier ones */
+  char** lines = g_strsplit(content, "\n", -1);
+
+  int i;
+  for(i = 0; lines[i]; i++)
+  {
+    char* key = strchr(lines[i], ' ');
+    if(lines[i][0] == '#' || !key)
+      continue;
+
+    *key++ = '\0';
+
+    if(!strcmp(lines[i], "!"))
+      g_key_file_remove_key(Zathura.Bookmarks.data, file, key, NULL);
+    else
+      g_key_file_set_integer(Zathura.Bookmarks.data, file, key, atoi(lines[i]));
+
+    Zathura.Bookmarks.records++;
+  }
+
+  g_strfreev(lines);
+  g_free(content);
+}
+
+void
+clear_bookmarks()
+{
+  if(Zathura.Bookmarks.data)
+    g_key_file_free(Zathura.Bookmarks.data);
+
+  int i;
+  for(i = 0; i < Zathura.Bookmarks.number_of_bookmarks; i++)
+    g_free(Zathura.Bookmarks.bookmarks[i].id);
+
+  free(Zathura.Bookmarks.bookmarks);
+  g_free(Zathura.Bookmarks.file);
+
+  Zathura.Bookmarks.data                = NULL;
+  Zathura.Bookmarks.file                = NULL;
+  Zathura.Bookmarks.records             = 0;
+  Zathura.Bookmarks.bookmarks           = NULL;
+  Zathura.Bookmarks.number_of_bookmarks = 0;
+}
+
+void
+load_costs(char* file)
+{
+  clear_costs();
+
+  /* the costs are kept next to the bookmark journal of the document */
+  char* checksum = g_compute_checksum_for_string(G_CHECKSUM_SHA1, file, -1);
+  char* name     = g_strconcat(checksum, COST_SUFFIX, NULL);
+
+  Zathura.Costs.file = g_build_filename(Zathura.Bookmarks.directory, name, NULL);
+  g_free(name);
+  g_free(checksum);
+
+  char* content = NULL;
+  if(!g_file_get_contents(Zathura.Costs.file, &content, NULL, NULL))
+    return;
+
+  char** lines = g_strsplit(content, "\n", -1);
+
+  int i;
+  for(i = 0; lines[i]; i++)
+  {
+    int page_id, cost;
+    if(lines[i][0] != '#' && sscanf(lines[i], "%d %d", &page_id, &cost) == 2 && page_id >= 0 && cost > 0)
+      g_hash_table_insert(Zathura.Costs.pages, GINT_TO_POINTER(page_id + 1), GINT_TO_POINTER(cost));
+  }
+
+  g_strfreev(lines);
+  g_free(content);
+}
+
+void
+save_costs()
+{
+  if(!Zathura.Costs.file || !Zathura.Costs.changed)
+    return;
+
+  GString* content = g_string_new("# microseconds per megapixel\n");
+
+  gpointer key, value;
+  GHashTableIter iter;
+  g_hash_table_iter_init(&iter, Zathura.Costs.pages);
+  while(g_hash_table_iter_next(&iter, &key, &value))
+    g_string_append_printf(content, "%d %d\n", GPOINTER_TO_INT(key) - 1, GPOINTER_TO_INT(value));
+
+  g_file_set_contents(Zathura.Costs.file, content->str, content->len, NULL);
+  g_string_free(content, TRUE);
+
+  Zathura.Costs.changed = FALSE;
+}
+
+void
+clear_costs()
+{
+  g_hash_table_remove_all(Zathura.Costs.pages);
+  g_free(Zathura.Costs.file);
+
+  Zathura.Costs.file      = NULL;
+  Zathura.Costs.changed   = FALSE;
+  Zathura.Costs.last_page = -1;
+}
+
+void
+record_cost(int page_id, cairo_surface_t* surface, double seconds)
+{
+  /* the cost is kept per megapixel, so it applies to every zoom level */
+  double megapixels = cairo_image_surface_get_width(surface) * (double) cairo_image_surface_get_height(surface) / 1e6;
+  if(megapixels <= 0)
+    return;
+
+  int cost = MAX(seconds * 1e6 / megapixels, 1);
+
+  /* a single render can be slowed down by other work, so the old value is
+   * only adjusted */
+  int old = GPOINTER_TO_INT(g_hash_table_lookup(Zathura.Costs.pages, GINT_TO_POINTER(page_id + 1)));
+  if(old)
+    cost = (old * 3 + cost) / 4;
+
+  g_hash_table_insert(Zathura.Costs.pages, GINT_TO_POINTER(page_id + 1), GINT_TO_POINTER(cost));
+  Zathura.Costs.changed = TRUE;
+}
+
+double
+predict_cost(int page_id)
+{
+  int cost = GPOINTER_TO_INT(g_hash_table_lookup(Zathura.Costs.pages, GINT_TO_POINTER(page_id + 1)));
+
+  /* pages that have never been rendered are assumed to be average */
+  if(!cost && g_hash_table_size(Zathura.Costs.pages))
+  {
+    double total = 0;
+
+    gpointer key, value;
+    GHashTableIter iter;
+    g_hash_table_iter_init(&iter, Zathura.Costs.pages);
+    while(g_hash_table_iter_next(&iter, &key, &value))
+      total += GPOINTER_TO_INT(value);
+
+    cost = total / g_hash_table_size(Zathura.Costs.pages);
+  }
+
+  double width, height;
+  get_page_size(page_id, &width, &height);
+
+  return cost * (width * height / 1e6) / 1e6;
+}
+
+void
+save_bookmarks()
+{
+  if(!Zathura.Bookmarks.data || !Zathura.Bookmarks.file)
+    return;
+
+  /* collect current state */
+  char* file        = Zathura.PDF.file;
+  GKeyFile* current = g_key_file_new();
+
+  g_key_file_set_integer(current, file, BM_PAGE_ENTRY, Zathura.PDF.page_number);
+  g_key_file_set_integer(current, file, BM_PAGE_OFFSET, Zathura.PDF.page_offset);
+
+  int i;
+  for(i = 0; i < Zathura.Bookmarks.number_of_bookmarks; i++)
+    g_key_file_set_integer(current, file, Zathura.Bookmarks.bookmarks[i].id,
+        Zathura.Bookmarks.bookmarks[i].page);
+
+  /* journal only what differs from the stored state */
+  GString* journal     = g_string_new("");
+  int changes          = 0;
+  gsize j;
+  gsize number_of_keys = 0;
+  gsize number_of_live = 0;
+  char** keys          = g_key_file_get_keys(current, file, &number_of_live, NULL);
+
+  for(j = 0; j < number_of_live; j++)
+  {
+    int value = g_key_file_get_integer(current, file, keys[j], NULL);
+
+    if(!g_key_file_has_key(Zathura.Bookmarks.data, file, keys[j], NULL) ||
+        g_key_file_get_integer(Zathura.Bookmarks.data, file, keys[j], NULL) != value)
+    {
+      g_string_append_printf(journal, "%d %s\n", value, keys[j]);
+      changes++;
+    }
+  }
+
+  g_strfreev(keys);
+  keys = g_key_file_get_keys(Zathura.Bookmarks.data, file, &number_of_keys, NULL);
+
+  for(j = 0; j < number_of_keys; j++)
+  {
+    if(!g_key_file_has_key(current, file, keys[j], NULL))
+    {
+      g_string_append_printf(journal, "! %s\n", keys[j]);
+      changes++;
+    }
+  }
+
+  g_strfreev(keys);
+
+  /* compact the journal once it is mostly overwritten records */
+  if(changes && Zathura.Bookmarks.records + changes > (int) number_of_live + BM_COMPACT)
+  {
+    GString* content = g_string_new("");
+    g_string_append_printf(content, "# %s\n", file);
+
+    keys = g_key_file_get_keys(current, file, &number_of_live, NULL);
+    for(j = 0; j < number_of_live; j++)
+      g_string_append_printf(content, "%d %s\n",
+          g_key_file_get_integer(current, file, keys[j], NULL), keys[j]);
+    g_strfreev(keys);
+
+    if(!g_file_set_contents(Zathura.Bookmarks.file, content->str, content->len, NULL))
+      notify(ERROR, "Could not save bookmarks");
+
+    g_string_free(content, TRUE);
+  }
+  else if(changes)
+  {
+    gboolean exists = g_file_test(Zathura.Bookmarks.file, G_FILE_TEST_EXISTS);
+    FILE* journal_file = fopen(Zathura.Bookmarks.file, "a");
+
+    if(journal_file)
+    {
+      if(!exists)
+        fprintf(journal_file, "# %s\n", file);
+
+      fputs(journal->str, journal_file);
+      fclose(journal_file);
+    }
+    else
+      notify(ERROR, "Could not save bookmarks");
+  }
+
+  g_string_free(journal, TRUE);
+  g_key_file_free(current);
+}
+
+void
+cache_document()
+{
+  CachedDocument* cached = malloc(sizeof(CachedDocument));
+  cached->file     = g_strdup(Zathura.PDF.file);
+  cached->mtime    = Zathura.PDF.mtime;
+  cached->size     = Zathura.PDF.file_size;
+  cached->document = Zathura.PDF.document;
+  cached->mapping  = Zathura.PDF.mapping;
+
+  g_static_mutex_lock(&(Zathura.Lock.cache_lock));
+  Zathura.Cache.documents = g_list_prepend(Zathura.Cache.documents, cached);
+
+  /* drop the documents that have been closed the longest time ago */
+  while(g_list_length(Zathura.Cache.documents) > DOCUMENT_CACHE)
+  {
+    GList* last = g_list_last(Zathura.Cache.documents);
+    free_cached_document((CachedDocument*) last->data);
+    Zathura.Cache.documents = g_list_delete_link(Zathura.Cache.documents, last);
+  }
+  g_static_mutex_unlock(&(Zathura.Lock.cache_lock));
+}
+
+gboolean
+take_cached_document(Loader* loader)
+{
+  struct stat information;
+  if(stat(loader->file, &information) != 0)
+    return FALSE;
+
+  loader->mtime     = information.st_mtime;
+  loader->file_size = information.st_size;
+
+  CachedDocument* cached = NULL;
+
+  g_static_mutex_lock(&(Zathura.Lock.cache_lock));
+  GList* list;
+  for(list = Zathura.Cache.documents; list; list = g_list_next(list))
+  {
+    if(!strcmp(((CachedDocument*) list->data)->file, loader->file))
+    {
+      cached = (CachedDocument*) list->data;
+      Zathura.Cache.documents = g_list_delete_link(Zathura.Cache.documents, list);
+      break;
+    }
+  }
+  g_static_mutex_unlock(&(Zathura.Lock.cache_lock));
+
+  if(!cached)
+    return FALSE;
+
+  /* the file has been changed since it was closed */
+  if(cached->mtime != loader->mtime || cached->size != loader->file_size)
+  {
+    free_cached_document(cached);
+    return FALSE;
+  }
+
+  loader->document = cached->document;
+  loader->mapping  = cached->mapping;
+  g_free(cached->file);
+  free(cached);
+
+  return TRUE;
+}
+
+void
+free_cached_document(CachedDocument* cached)
+{
+  g_static_mutex_lock(&(Zathura.Lock.pdflib_lock));
+  g_object_unref(cached->document);
+  g_static_mutex_unlock(&(Zathura.Lock.pdflib_lock));
+  unmap_file(cached->mapping);
+  g_free(cached->file);
+  free(cached);
+}
+
+int
+connect_server(char* path)
+{
+  struct sockaddr_un address;
+  if(strlen(path) >= sizeof(address.sun_path))
+    return -1;
+
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strcpy(address.sun_path, path);
+
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if(fd == -1)
+    return -1;
+
+  if(connect(fd, (struct sockaddr*) &address, sizeof(address)) == -1)
+  {
+    close(fd);
+    return -1;
+  }
+
+  return fd;
+}
+
+int
+send_to_server(char* file, char* command)
+{
+  /* documents from the standard input can not be passed on */
+  if(file && !strcmp(file, "-"))
+    return -1;
+
+  char* path = g_build_filename(g_get_user_runtime_dir(), SERVER_SOCKET, NULL);
+  int fd     = connect_server(path);
+  g_free(path);
+
+  if(fd == -1)
+    return -1;
+
+  if(!file && !command)
+  {
+    close(fd);
+    fprintf(stderr, "zathura: an instance is already running, pass it a file or a command\n");
+    return 1;
+  }
+
+  /* the running instance executes one command per line */
+  GString* lines = g_string_new("");
+
+  if(file)
+  {
+    char* real_path = realpath(file, NULL);
+    g_string_append_printf(lines, "open %s\n", real_path ? real_path : file);
+    free(real_path);
+  }
+
+  if(command)
+    g_string_append_printf(lines, "%s\n", command);
+
+  gboolean sent = write_data(fd, lines->str, lines->len);
+
+  close(fd);
+  g_string_free(lines, TRUE);
+
+  if(!sent)
+  {
+    fprintf(stderr, "zathura: could not pass the arguments on to the running instance\n");
+    return 1;
+  }
+
+  return 0;
+}
+
+gboolean
+write_data(int fd, const char* data, gsize length)
+{
+  gsize written = 0;
+  while(written < length)
+  {
+    /* a client that went away must not kill the process */
+    ssize_t count = send(fd, data + written, length - written, MSG_NOSIGNAL);
+    if(count < 0 && errno != EINTR)
+      return FALSE;
+    else if(count > 0)
+      written += count;
+  }
+
+  return TRUE;
+}
+
+int
+listen_socket(char* path)
+{
+  struct sockaddr_un address;
+  if(strlen(path) >= sizeof(address.sun_path))
+    return -1;
+
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strcpy(address.sun_path, path);
+
+  /* nobody answered on the socket, so it is left over from a crash */
+  unlink(path);
+
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if(fd == -1)
+    return -1;
+
+  if(bind(fd, (struct sockaddr*) &address, sizeof(address)) == -1 ||
+      listen(fd, 8) == -1)
+  {
+    close(fd);
+    return -1;
+  }
+
+  return fd;
+}
+
+void
+start_server()
+{
+  Zathura.Server.fd = listen_socket(Zathura.Server.socket);
+  if(Zathura.Server.fd == -1)
+  {
+    notify(WARNING, "Could not start server");
+    return;
+  }
+
+  Zathura.Server.channel = g_io_channel_unix_new(Zathura.Server.fd);
+  Zathura.Server.watch   = g_io_add_watch(Zathura.Server.channel, G_IO_IN, cb_server_accept, NULL);
+}
+
+int
+run_daemon()
+{
+  char* path = g_build_filename(g_get_user_runtime_dir(), RENDER_SOCKET, NULL);
+
+  int fd = connect_server(path);
+  if(fd != -1)
+  {
+    fprintf(stderr, "zathura: A render daemon is already listening on %s\n", path);
+    close(fd);
+    g_free(path);
+    return 1;
+  }
+
+  fd = listen_socket(path);
+  if(fd == -1)
+  {
+    fprintf(stderr, "zathura: Could not listen on %s\n", path);
+    g_free(path);
+    return 1;
+  }
+
+  g_free(path);
+
+  /* rasters are recolored like in the viewer */
+  gdk_color_parse(recolor_darkcolor,  &(Zathura.Style.recolor_darkcolor));
+  gdk_color_parse(recolor_lightcolor, &(Zathura.Style.recolor_lightcolor));
+  Zathura.Global.recolor = RECOLOR_OPEN;
+
+  Zathura.Daemon.documents      = NULL;
+  Zathura.Daemon.lock           = g_mutex_new();
+  Zathura.Daemon.released       = g_cond_new();
+  Zathura.Daemon.documents_size = 0;
+  Zathura.Daemon.rasters_size   = 0;
+  Zathura.Daemon.pool           = g_thread_pool_new(serve_client, NULL, RENDER_WORKERS, FALSE, NULL);
+
+  /* every connection is served by one of the workers */
+  int client;
+  while((client = accept(fd, NULL, NULL)) != -1 || errno == EINTR)
+  {
+    if(client != -1)
+      g_thread_pool_push(Zathura.Daemon.pool, GINT_TO_POINTER(client + 1), NULL);
+  }
+
+  close(fd);
+
+  return 1;
+}
+
+RenderDocument*
+acquire_document(char* file, PopplerDocument** copy)
+{
+  struct stat information;
+  if(stat(file, &information) != 0)
+    return NULL;
+
+  g_mutex_lock(Zathura.Daemon.lock);
+  GList* list = Zathura.Daemon.documents;
+  while(list)
+  {
+    RenderDocument* document = (RenderDocument*) list->data;
+    if(strcmp(document->file, file))
+    {
+      list = g_list_next(list);
+      continue;
+    }
+
+    /* another worker is parsing the file, its document is taken */
+    if(document->opening)
+    {
+      g_cond_wait(Zathura.Daemon.released, Zathura.Daemon.lock);
+      list = Zathura.Daemon.documents;
+      continue;
+    }
+
+    Zathura.Daemon.documents = g_list_remove_link(Zathura.Daemon.documents, list);
+
+    /* the most recently used documents are kept at the front */
+    if(document->mtime == information.st_mtime && document->size == information.st_size)
+    {
+      document->users++;
+      Zathura.Daemon.documents = g_list_concat(list, Zathura.Daemon.documents);
+
+      /* poppler documents are not shared between threads, every worker
+       * takes a copy nobody renders from or parses one of its own */
+      *copy = NULL;
+      if(document->copies)
+      {
+        *copy = (PopplerDocument*) document->copies->data;
+        document->copies = g_list_delete_link(document->copies, document->copies);
+      }
+      g_mutex_unlock(Zathura.Daemon.lock);
+
+      if(*copy)
+        return document;
+
+      *copy = poppler_document_new_from_data(document->mapping->data, document->mapping->length, NULL, NULL);
+      if(!*copy)
+      {
+        release_document(document, NULL);
+        return NULL;
+      }
+
+      g_mutex_lock(Zathura.Daemon.lock);
+      if(!document->stale)
+        Zathura.Daemon.documents_size += document->mapping->length;
+      document->parsed++;
+      g_mutex_unlock(Zathura.Daemon.lock);
+
+      return document;
+    }
+
+    /* the file has been changed, the old document goes once it is unused */
+    g_list_free_1(list);
+    Zathura.Daemon.documents_size -= document_cost(document);
+
+    if(document->users == 0)
+      free_render_document(document);
+    else
+      document->stale = TRUE;
+
+    break;
+  }
+
+  /* the file is opened once, other requests for it wait until it is */
+  RenderDocument* document = malloc(sizeof(RenderDocument));
+  document->file     = g_strdup(file);
+  document->mtime    = information.st_mtime;
+  document->size     = information.st_size;
+  document->copies   = NULL;
+  document->parsed   = 0;
+  document->mapping  = NULL;
+  document->users    = 1;
+  document->stale    = FALSE;
+  document->opening  = TRUE;
+
+  Zathura.Daemon.documents = g_list_prepend(Zathura.Daemon.documents, document);
+  g_mutex_unlock(Zathura.Daemon.lock);
+
+  /* the document is parsed without holding the lock */
+  Mapping* mapping = map_file(file);
+  *copy            = mapping ? poppler_document_new_from_data(mapping->data, mapping->length, NULL, NULL) : NULL;
+
+  g_mutex_lock(Zathura.Daemon.lock);
+  document->mapping = mapping;
+  document->opening = FALSE;
+
+  if(*copy)
+  {
+    document->parsed               = 1;
+    Zathura.Daemon.documents_size += document_cost(document);
+  }
+  else
+  {
+    Zathura.Daemon.documents = g_list_remove(Zathura.Daemon.documents, document);
+    free_render_document(document);
+    document = NULL;
+  }
+
+  g_cond_broadcast(Zathura.Daemon.released);
+  g_mutex_unlock(Zathura.Daemon.lock);
+
+  return document;
+}
+
+gsize
+document_cost(RenderDocument* document)
+{
+  /* poppler does not tell how much a parsed document takes, every copy
+   * is charged as much as the file it has been parsed from */
+  if(!document->mapping)
+    return 0;
+
+  return (gsize) document->mapping->length * (document->parsed + 1);
+}
+
+void
+release_document(RenderDocument* document, PopplerDocument* copy)
+{
+  g_mutex_lock(Zathura.Daemon.lock);
+  document->users--;
+
+  /* the copies of a changed file are of no use to the next request */
+  if(copy && document->stale)
+    g_object_unref(copy);
+  else if(copy)
+    document->copies = g_list_prepend(document->copies, copy);
+
+  if(document->stale && document->users == 0)
+    free_render_document(document);
+
+  g_cond_broadcast(Zathura.Daemon.released);
+  g_mutex_unlock(Zathura.Daemon.lock);
+}
+
+void
+free_render_document(RenderDocument* document)
+{
+  GList* list;
+  for(list = document->copies; list; list = g_list_next(list))
+    g_object_unref(list->data);
+
+  g_list_free(document->copies);
+
+  unmap_file(document->mapping);
+  g_free(document->file);
+  free(document);
+}
+
+gboolean
+reserve_memory(gsize bytes)
+{
+  gsize budget = (gsize) RENDER_BUDGET << 20;
+  if(bytes > budget)
+    return FALSE;
+
+  g_mutex_lock(Zathura.Daemon.lock);
+  while(Zathura.Daemon.documents_size + Zathura.Daemon.rasters_size + bytes > budget)
+  {
+    /* drop the least recently used document nobody renders from */
+    GList* list = g_list_last(Zathura.Daemon.documents);
+    while(list && ((RenderDocument*) list->data)->users > 0)
+      list = g_list_previous(list);
+
+    if(list)
+    {
+      RenderDocument* document = (RenderDocument*) list->data;
+      Zathura.Daemon.documents       = g_list_delete_link(Zathura.Daemon.documents, list);
+      Zathura.Daemon.documents_size -= document_cost(document);
+      free_render_document(document);
+    }
+    /* wait for other rasters to be sent */
+    else if(Zathura.Daemon.rasters_size > 0)
+      g_cond_wait(Zathura.Daemon.released, Zathura.Daemon.lock);
+    /* only documents that are in use are left */
+    else
+      break;
+  }
+
+  Zathura.Daemon.rasters_size += bytes;
+  g_mutex_unlock(Zathura.Daemon.lock);
+
+  return TRUE;
+}
+
+void
+release_memory(gsize bytes)
+{
+  g_mutex_lock(Zathura.Daemon.lock);
+  Zathura.Daemon.rasters_size -= bytes;
+  g_cond_broadcast(Zathura.Daemon.released);
+  g_mutex_unlock(Zathura.Daemon.lock);
+}
+
+gboolean
+serve_request(int fd, char* request)
+{
+  int page_id = 0, scale = 0, rotate = 0, offset = 0;
+  char format[4] = "";
+  char* error    = NULL;
+
+  /* pages FILE */
+  if(!strncmp(request, "pages ", 6))
+  {
+    PopplerDocument* copy    = NULL;
+    RenderDocument* document = acquire_document(request + 6, &copy);
+
+    char* reply = document ? g_strdup_printf("OK %d\n", poppler_document_get_n_pages(copy))
+      : g_strdup("ERROR Could not open file\n");
+    gboolean sent = write_data(fd, reply, strlen(reply));
+    g_free(reply);
+
+    if(document)
+      release_document(document, copy);
+
+    return sent;
+  }
+
+  /* render PAGE SCALE ROTATION FORMAT FILE */
+  if(sscanf(request, "render %d %d %d %3s %n", &page_id, &scale, &rotate, format, &offset) != 4
+      || offset == 0 || (strcmp(format, "png") && strcmp(format, "raw")))
+    error = "Invalid request";
+  else if(scale < ZOOM_MIN || scale > ZOOM_MAX || rotate < 0 || rotate > 270 || rotate % 90)
+    error = "Invalid scale or rotation";
+
+  RenderDocument* document = NULL;
+  PopplerDocument* copy    = NULL;
+  PopplerPage* page        = NULL;
+  gsize reserved           = 0;
+
+  if(!error && !(document = acquire_document(request + offset, &copy)))
+    error = "Could not open file";
+
+  /* the copy belongs to this worker alone and needs no lock */
+  if(!error)
+  {
+    double page_width = 0, page_height = 0;
+
+    if(page_id > 0 && page_id <= poppler_document_get_n_pages(copy))
+      page = poppler_document_get_page(copy, page_id - 1);
+    if(page)
+      poppler_page_get_size(page, &page_width, &page_height);
+
+    reserved = (gsize) (page_width * scale / 100.0 + 1) * (gsize) (page_height * scale / 100.0 + 1) * 4;
+
+    if(!page)
+      error = "Invalid page";
+    else if(!reserve_memory(reserved))
+    {
+      error    = "Page exceeds the memory budget";
+      reserved = 0;
+    }
+  }
+
+  gboolean sent = FALSE;
+
+  if(error)
+  {
+    char* reply = g_strdup_printf("ERROR %s\n", error);
+    sent = write_data(fd, reply, strlen(reply));
+    g_free(reply);
+  }
+  else
+  {
+    cairo_surface_t* surface = render_page(page, scale, rotate, NULL, NULL);
+
+    if(Zathura.Global.recolor)
+      recolor_surface(surface);
+
+    cairo_surface_flush(surface);
+
+    int width  = cairo_image_surface_get_width(surface);
+    int height = cairo_image_surface_get_height(surface);
+    int stride = cairo_image_surface_get_stride(surface);
+
+    /* raw rasters are sent as cairo keeps them in memory */
+    GByteArray* png     = NULL;
+    const char* data    = (const char*) cairo_image_surface_get_data(surface);
+    gsize       length  = stride * height;
+
+    if(!strcmp(format, "png"))
+    {
+      png    = g_byte_array_new();
+      cairo_surface_write_to_png_stream(surface, cb_write_png, png);
+      data   = (const char*) png->data;
+      length = png->len;
+      stride = 0;
+    }
+
+    char* reply = g_strdup_printf("OK %d %d %d %lu\n", width, height, stride, (unsigned long) length);
+    sent = write_data(fd, reply, strlen(reply)) && write_data(fd, data, length);
+    g_free(reply);
+
+    if(png)
+      g_byte_array_free(png, TRUE);
+    cairo_surface_destroy(surface);
+  }
+
+  if(reserved)
+    release_memory(reserved);
+
+  if(page)
+    g_object_unref(page);
+
+  if(document)
+    release_document(document, copy);
+
+  return sent;
+}
+
+int
+run_batch(char* file, char* range, int scale, int rotate, char* directory)
+{
+  if(scale < ZOOM_MIN || scale > ZOOM_MAX || rotate < 0 || rotate > 270 || rotate % 90)
+  {
+    fprintf(stderr, "zathura: Invalid scale or rotation\n");
+    return 1;
+  }
+
+  /* every worker parses the same mapping into a document of its own */
+  Mapping* mapping = map_file(file);
+  if(!mapping)
+  {
+    fprintf(stderr, "zathura: Could not open %s\n", file);
+    return 1;
+  }
+
+  GError* error = NULL;
+  PopplerDocument* document = poppler_document_new_from_data(mapping->data, mapping->length, NULL, &error);
+  if(!document)
+  {
+    fprintf(stderr, "zathura: Could not open %s: %s\n", file, error->message);
+    g_error_free(error);
+    unmap_file(mapping);
+    return 1;
+  }
+
+  Batch batch;
+  batch.mapping   = mapping;
+  batch.pages     = parse_page_range(range, poppler_document_get_n_pages(document), &(batch.number_of_pages));
+  batch.next      = 0;
+  batch.rendered  = 0;
+  batch.scale     = scale;
+  batch.rotate    = rotate;
+  batch.directory = directory;
+  g_object_unref(document);
+
+  if(!batch.pages)
+  {
+    fprintf(stderr, "zathura: Invalid page range %s\n", range);
+    unmap_file(mapping);
+    return 1;
+  }
+
+  g_mkdir_with_parents(directory, 0755);
+
+  /* rasters are recolored like in the viewer */
+  gdk_color_parse(recolor_darkcolor,  &(Zathura.Style.recolor_darkcolor));
+  gdk_color_parse(recolor_lightcolor, &(Zathura.Style.recolor_lightcolor));
+  Zathura.Global.recolor = RECOLOR_OPEN;
+
+  long number_of_workers = sysconf(_SC_NPROCESSORS_ONLN);
+  if(number_of_workers < 1)
+    number_of_workers = 1;
+  if(number_of_workers > batch.number_of_pages)
+    number_of_workers = batch.number_of_pages;
+
+  GTimer* timer     = g_timer_new();
+  GThread** workers = malloc(number_of_workers * sizeof(GThread*));
+
+  int i;
+  for(i = 0; i < number_of_workers; i++)
+    workers[i] = g_thread_create(render_batch, &batch, TRUE, NULL);
+
+  for(i = 0; i < number_of_workers; i++)
+  {
+    if(workers[i])
+      g_thread_join(workers[i]);
+  }
+
+  /* a single worker is enough to finish the batch */
+  if(!workers[0])
+    render_batch(&batch);
+
+  double elapsed = g_timer_elapsed(timer, NULL);
+
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+
+  printf("Rendered %d of %d pages in %.2f s (%.1f pages/s), peak memory %ld MiB\n",
+      batch.rendered, batch.number_of_pages, elapsed,
+      (elapsed > 0) ? batch.rendered / elapsed : 0.0, usage.ru_maxrss / 1024);
+
+  g_timer_destroy(timer);
+  free(workers);
+  free(batch.pages);
+  unmap_file(mapping);
+
+  return (batch.rendered == batch.number_of_pages) ? 0 : 1;
+}
+
+int
+run_client(char* file, char* range, int scale, int rotate, char* directory)
+{
+  char* path = g_build_filename(g_get_user_runtime_dir(), RENDER_SOCKET, NULL);
+  int fd     = connect_server(path);
+
+  if(fd == -1)
+  {
+    fprintf(stderr, "zathura: No render daemon is listening on %s\n", path);
+    g_free(path);
+    return 1;
+  }
+
+  g_free(path);
+
+  /* the daemon resolves the file relative to its own directory */
+  char* real_path = realpath(file, NULL);
+  if(!real_path)
+  {
+    fprintf(stderr, "zathura: Could not open %s\n", file);
+    close(fd);
+    return 1;
+  }
+
+  FILE* stream = fdopen(fd, "r");
+  if(!stream)
+  {
+    close(fd);
+    free(real_path);
+    return 1;
+  }
+
+  char* line        = NULL;
+  size_t line_size  = 0;
+  int number_of_ids = 0;
+  int* ids          = NULL;
+  int received      = 0;
+  int count         = 0;
+
+  char* request = g_strdup_printf("pages %s\n", real_path);
+  if(write_data(fd, request, strlen(request)) && getline(&line, &line_size, stream) != -1
+      && sscanf(line, "OK %d", &count) == 1)
+    ids = parse_page_range(range, count, &number_of_ids);
+  else
+    fprintf(stderr, "zathura: %s", (line && !strncmp(line, "ERROR ", 6)) ? line + 6 : "No reply from the render daemon\n");
+  g_free(request);
+
+  if(count > 0 && !ids)
+    fprintf(stderr, "zathura: Invalid page range %s\n", range);
+
+  if(ids)
+    g_mkdir_with_parents(directory, 0755);
+
+  GTimer* timer = g_timer_new();
+
+  /* the pages are requested one after another on the same connection */
+  int i;
+  for(i = 0; i < number_of_ids; i++)
+  {
+    request = g_strdup_printf("render %d %d %d png %s\n", ids[i] + 1, scale, rotate, real_path);
+    gboolean sent = write_data(fd, request, strlen(request));
+    g_free(request);
+
+    int width = 0, height = 0, stride = 0;
+    unsigned long length = 0;
+    if(!sent || getline(&line, &line_size, stream) == -1)
+    {
+      fprintf(stderr, "zathura: The render daemon hung up\n");
+      break;
+    }
+    else if(sscanf(line, "OK %d %d %d %lu", &width, &height, &stride, &length) != 4)
+    {
+      fprintf(stderr, "zathura: Page %d: %s", ids[i] + 1, !strncmp(line, "ERROR ", 6) ? line + 6 : line);
+      continue;
+    }
+
+    gchar* data = g_malloc(length);
+    if(fread(data, 1, length, stream) != length)
+    {
+      fprintf(stderr, "zathura: The render daemon hung up\n");
+      g_free(data);
+      break;
+    }
+
+    char* output = g_strdup_printf("%s/page-%04d.png", directory, ids[i] + 1);
+
+    if(g_file_set_contents(output, data, length, NULL))
+      received++;
+    else
+      fprintf(stderr, "zathura: Could not write %s\n", output);
+
+    g_free(output);
+    g_free(data);
+  }
+
+  double elapsed = g_timer_elapsed(timer, NULL);
+
+  if(ids)
+    printf("Received %d of %d pages in %.2f s (%.1f pages/s)\n", received, number_of_ids, elapsed,
+        (elapsed > 0) ? received / elapsed : 0.0);
+
+  g_timer_destroy(timer);
+  free(ids);
+  free(line);
+  free(real_path);
+  fclose(stream);
+
+  return (ids && received == number_of_ids) ? 0 : 1;
+}
+
+int*
+parse_page_range(char* range, int number_of_pages, int* number_of_ids)
+{
+  /* all pages by default, otherwise something like 1-10,12,20-30 */
+  char* all = g_strdup_printf("1-%d", number_of_pages);
+  char** parts = g_strsplit(range ? range : all, ",", -1);
+  g_free(all);
+
+  int* ids = NULL;
+  *number_of_ids = 0;
+
+  int i;
+  for(i = 0; parts[i]; i++)
+  {
+    int first = 0, last = 0;
+    int count = sscanf(parts[i], "%d-%d", &first, &last);
+
+    if(count == 1)
+      last = first;
+
+    if(count < 1 || first < 1 || last < first || last > number_of_pages)
+    {
+      free(ids);
+      g_strfreev(parts);
+      return NULL;
+    }
+
+    ids = realloc(ids, (*number_of_ids + last - first + 1) * sizeof(int));
+
+    int page_id;
+    for(page_id = first - 1; page_id < last; page_id++)
+      ids[(*number_of_ids)++] = page_id;
+  }
+
+  g_strfreev(parts);
+
+  return ids;
+}
+
+void
+parse_document(Loader* loader)
+{
+  /* the standard input and the output of decompressors are read into
+   * memory, files are mapped; poppler reads both without a copy */
+  if(loader->input)
+    loader->mapping = map_stream(STDIN_FILENO);
+  else if(loader->command)
+  {
+    FILE* pipe = popen(loader->command, "r");
+    if(pipe)
+    {
+      loader->mapping = map_stream(fileno(pipe));
+      if(pclose(pipe) != 0)
+      {
+        unmap_file(loader->mapping);
+        loader->mapping = NULL;
+      }
+    }
+  }
+  else if(MMAP_OPEN)
+    loader->mapping = map_file(loader->file);
+
+  if((loader->input || loader->command) && !loader->mapping)
+    g_set_error(&(loader->error), G_FILE_ERROR, G_FILE_ERROR_FAILED, "Could not read %s",
+        loader->input ? "the standard input" : loader->file);
+
+  struct stat information;
+  if(loader->mapping)
+    loader->size = loader->mapping->length;
+  else if(!loader->input && stat(loader->file, &information) == 0)
+    loader->size = information.st_size;
+
+  g_static_mutex_lock(&(Zathura.Lock.pdflib_lock));
+  if(loader->mapping)
+    loader->document = poppler_document_new_from_data(loader->mapping->data, loader->mapping->length,
+        loader->password, &(loader->error));
+  else if(!loader->error)
+  {
+    char* file_uri = g_filename_to_uri(loader->file, NULL, &(loader->error));
+    if(file_uri)
+      loader->document = poppler_document_new_from_file(file_uri, loader->password, &(loader->error));
+    g_free(file_uri);
+  }
+  g_static_mutex_unlock(&(Zathura.Lock.pdflib_lock));
+}
+
+void
+start_loader(char* file, char* password, int start_page, gboolean refresh)
+{
+  Loader* loader     = malloc(sizeof(Loader));
+  loader->id         = Zathura.Thread.load_id;
+  loader->refresh    = refresh;
+  loader->input      = !strcmp(file, "-");
+  loader->command    = NULL;
+  loader->file       = g_strdup(file);
+  loader->password   = password ? g_strdup(password) : NULL;
+  loader->start_page = start_page;
+  loader->size       = 0;
+  loader->mtime      = 0;
+  loader->file_size  = 0;
+  loader->mapping    = NULL;
+  loader->document   = NULL;
+  loader->page       = NULL;
+  loader->error      = NULL;
+
+  /* compressed files are decompressed by an external program */
+  int i;
+  for(i = 0; i < LENGTH(decompressors) && !loader->input; i++)
+  {
+    if(g_str_has_suffix(file, decompressors[i].suffix))
+    {
+      char* quoted_file = g_shell_quote(file);
+      loader->command   = g_strdup_printf(decompressors[i].command, quoted_file);
+      g_free(quoted_file);
+      break;
+    }
+  }
+
+  Zathura.Stream.parsing = TRUE;
+
+  /* the user is waiting for the document, so it is loaded like a visible page */
+  if(!push_job(load_document, loader, PRIORITY_VISIBLE, NULL, NULL))
+    load_document(loader);
+}
+
+Page*
+load_page(int page_id)
+{
+  if(Zathura.PDF.pages[page_id])
+    return Zathura.PDF.pages[page_id];
+
+  Page* page      = malloc(sizeof(Page));
+  page->id        = page_id + 1;
+  page->recording = 0;
+
+  g_static_mutex_lock(&(Zathura.Lock.pdflib_lock));
+  page->page = poppler_document_get_page(Zathura.PDF.document, page_id);
+  g_object_get(G_OBJECT(page->page), "label", &(page->label), NULL);
+  g_static_mutex_unlock(&(Zathura.Lock.pdflib_lock));
+
+  /* check if it is necessary to use the label mode */
+  int label_int = atoi(page->label);
+  if(label_int == 0 || label_int != page->id)
+    Zathura.Global.enable_labelmode = TRUE;
+
+  Zathura.PDF.pages[page_id] = page;
+
+  return page;
+}
+
+void
+free_pages()
+{
+  int i;
+  for(i = 0; i < Zathura.PDF.number_of_pages && Zathura.PDF.pages; i++)
+  {
+    Page* page = Zathura.PDF.pages[i];
+    if(!page)
+      continue;
+
+    g_static_mutex_lock(&(Zathura.Lock.pdflib_lock));
+    g_object_unref(page->page);
+    g_static_mutex_unlock(&(Zathura.Lock.pdflib_lock));
+
+    g_free(page->label);
+    free(page);
+  }
+
+  free(Zathura.PDF.pages);
+  Zathura.PDF.pages = NULL;
+}
+
+void open_uri(char* uri)
+{
+  char* uri_cmd = g_strdup_printf(URI_COMMAND, uri);
+  system(uri_cmd);
+  g_free(uri_cmd);
+}
+
+void
+update_status()
+{
+  /* update text */
+  gtk_label_set_markup((GtkLabel*) Zathura.Global.status_text, Zathura.State.filename);
+
+  /* update pages */
+  if( Zathura.PDF.document && Zathura.PDF.pages )
+  {
+    int page = Zathura.PDF.page_number;
+    /*
+    if((Zathura.Global.goto_mode == GOTO_LABELS) && Zathura.PDF.pages[page]->label)
+      Zathura.State.pages = g_strdup_printf("[%s/%i]", 
+          Zathura.PDF.pages[page]->label, Zathura.PDF.number_of_pages);
+    else
+    */
+      Zathura.State.pages = g_strdup_printf("[%i/%i]", page + 1, Zathura.PDF.number_of_pages);
+  }
+
+  /* update state */
+  char* zoom_level  = (Zathura.PDF.scale != 0) ? g_strdup_printf("%d%%", Zathura.PDF.scale) : "";
+  char* goto_mode   = (Zathura.Global.goto_mode == GOTO_LABELS) ? "L" : 
+    (Zathura.Global.goto_mode == GOTO_OFFSET) ? "O" : "D";
+  char* status_text = g_strdup_printf("%s [%s] %s", zoom_level, goto_mode, Zathura.State.pages);
+  gtk_label_set_markup((GtkLabel*) Zathura.Global.status_state, status_text);
+}
+
+void
+recalcRectangle(int page_id, PopplerRectangle* rectangle)
+{
+  double page_width, page_height;
+  double x1 = rectangle->x1;
+  double x2 = rectangle->x2;
+  double y1 = rectangle->y1;
+  double y2 = rectangle->y2;
+
+  g_static_mutex_lock(&(Zathura.Lock.pdflib_lock));
+  poppler_page_get_size(Zathura.PDF.pages[page_id]->page, &page_width, &page_height);
+  g_static_mutex_unlock(&(Zathura.Lock.pdflib_lock));
+
+  double scale = ((double) Zathura.PDF.scale / 100.0);
+
+  int rotate = Zathura.PDF.rotate;
+
+  switch(rotate)
+  {
+    case 90:
+      rectangle->x1 = y2 * scale;
+      rectangle->y1 = x1 * scale;
+      rectangle->x2 = y1 * scale;
+      rectangle->y2 = x2 * scale;
+      break;
+    case 180:
+      rectangle->x1 = (page_width  - x2) * scale;
+      rectangle->y1 = y2 * scale;
+      rectangle->x2 = (page_width  - x1) * scale;
+      rectangle->y2 = y1 * scale;
+      break;
+    case 270:
+      rectangle->x1 = (page_height - y1) * scale;
+      rectangle->y1 = (page_width  - x2) * scale;
+      rectangle->x2 = (page_height - y2) * scale;
+      rectangle->y2 = (page_width  - x1) * scale;
+      break;
+    default:
+      rectangle->x1 = x1  * scale;
+      rectangle->y1 = (page_height - y1) * scale;
+      rectangle->x2 = x2  * scale;
+      rectangle->y2 = (page_height - y2) * scale;
+  }
+}
+
+GtkEventBox*
+createCompletionRow(GtkBox* results, char* command, char* description, gboolean group)
+{
+  GtkBox      *col = GTK_BOX(gtk_hbox_new(FALSE, 0));
+  GtkEventBox *row = GTK_EVENT_BOX(gtk_event_box_new());
+
+  GtkLabel *show_command     = GTK_LABEL(gtk_label_new(NULL));
+  GtkLabel *show_description = GTK_LABEL(gtk_label_new(NULL));
+
+  gtk_misc_set_alignment(GTK_MISC(show_command),     0.0, 0.0);
+  gtk_misc_set_alignment(GTK_MISC(show_description), 0.0, 0.0);
+
+  if(group)
+  {
+    gtk_misc_set_padding(GTK_MISC(show_command),     2.0, 4.0);
+    gtk_misc_set_padding(GTK_MISC(show_description), 2.0, 4.0);
+  }
+  else
+  {
+    gtk_misc_set_padding(GTK_MISC(show_command),     1.0, 1.0);
+    gtk_misc_set_padding(GTK_MISC(show_description), 1.0, 1.0);
+  }
+
+  gtk_label_set_use_markup(show_command,     TRUE);
+  gtk_label_set_use_markup(show_description, TRUE);
+
+  gtk_label_set_markup(show_command,     g_markup_printf_escaped(FORMAT_COMMAND,     command ? command : ""));
+  gtk_label_set_markup(show_description, g_markup_printf_escaped(FORMAT_DESCRIPTION, description ? description : ""));
+
+  if(group)
+  {
+    gtk_widget_modify_fg(GTK_WIDGET(show_command),     GTK_STATE_NORMAL, &(Zathura.Style.completion_g_fg));
+    gtk_widget_modify_fg(GTK_WIDGET(show_description), GTK_STATE_NORMAL, &(Zathura.Style.completion_g_fg));
+    gtk_widget_modify_bg(GTK_WIDGET(row),              GTK_STATE_NORMAL, &(Zathura.Style.completion_g_bg));
+  }
+  else
+  {
+    gtk_widget_modify_fg(GTK_WIDGET(show_command),     GTK_STATE_NORMAL, &(Zathura.Style.completion_fg));
+    gtk_widget_modify_fg(GTK_WIDGET(show_description), GTK_STATE_NORMAL, &(Zathura.Style.completion_fg));
+    gtk_widget_modify_bg(GTK_WIDGET(row),              GTK_STATE_NORMAL, &(Zathura.Style.completion_bg));
+  }
+
+  gtk_widget_modify_font(GTK_WIDGET(show_command),     Zathura.Style.font);
+  gtk_widget_modify_font(GTK_WIDGET(show_description), Zathura.Style.font);
+
+  gtk_box_pack_start(GTK_BOX(col), GTK_WIDGET(show_command),     TRUE,  TRUE,  2);
+  gtk_box_pack_start(GTK_BOX(col), GTK_WIDGET(show_description), FALSE, FALSE, 2);
+
+  gtk_container_add(GTK_CONTAINER(row), GTK_WIDGET(col));
+
+  gtk_box_pack_start(results, GTK_WIDGET(row), FALSE, FALSE, 0);
+
+  return row;
+}
+
+void
+setCompletionRowColor(GtkBox* results, int mode, int id)
+{
+  GtkEventBox *row   = (GtkEventBox*) g_list_nth_data(gtk_container_get_children(GTK_CONTAINER(results)), id);
+ 
+  if(row)
+  {
+    GtkBox      *col   = (GtkBox*)      g_list_nth_data(gtk_container_get_children(GTK_CONTAINER(row)), 0);
+    GtkLabel    *cmd   = (GtkLabel*)    g_list_nth_data(gtk_container_get_children(GTK_CONTAINER(col)), 0);
+    GtkLabel    *cdesc = (GtkLabel*)    g_list_nth_data(gtk_container_get_children(GTK_CONTAINER(col)), 1);
+
+    if(mode == NORMAL)
+    {
+      gtk_widget_modify_fg(GTK_WIDGET(cmd),   GTK_STATE_NORMAL, &(Zathura.Style.completion_fg));
+      gtk_widget_modify_fg(GTK_WIDGET(cdesc), GTK_STATE_NORMAL, &(Zathura.Style.completion_fg));
+      gtk_widget_modify_bg(GTK_WIDGET(row),   GTK_STATE_NORMAL, &(Zathura.Style.completion_bg));
+    }
+    else
+    {
+      gtk_widget_modify_fg(GTK_WIDGET(cmd),   GTK_STATE_NORMAL, &(Zathura.Style.completion_hl_fg));
+      gtk_widget_modify_fg(GTK_WIDGET(cdesc), GTK_STATE_NORMAL, &(Zathura.Style.completion_hl_fg));
+      gtk_widget_modify_bg(GTK_WIDGET(row),   GTK_STATE_NORMAL, &(Zathura.Style.completion_hl_bg));
+    }
+  }
+}
+
+void
+set_page(int page)
+{
+  if(!Zathura.PDF.document || page >= Zathura.PDF.number_of_pages || page < 0)
+  {
+    notify(WARNING, "Could not open page");
+    return;
+  }
+
+  load_page(page);
+  Zathura.PDF.page_number = page;
+
+  Argument argument;
+  argument.n = TOP;
+  sc_scroll(&argument);
+
+  switch_view(Zathura.UI.drawing_area);
+  draw(page);
+}
+
+void
+switch_view(GtkWidget* widget)
+{
+  GtkWidget* child = gtk_bin_get_child(GTK_BIN(Zathura.UI.viewport));
+  if(child)
+  {
+    g_object_ref(child);
+    gtk_container_remove(GTK_CONTAINER(Zathura.UI.viewport), child);
+  }
+
+  gtk_container_add(GTK_CONTAINER(Zathura.UI.viewport), GTK_WIDGET(widget));
+}
+
+void
+open_overview()
+{
+  if(Zathura.Overview.documents)
+    return;
+
+  /* every worker takes a document of its own from the queue */
+  Zathura.Overview.documents = g_async_queue_new();
+  Zathura.Overview.shared    = FALSE;
+
+  int i;
+  for(i = 0; i < OVERVIEW_WORKERS; i++)
+  {
+    PopplerDocument* document = copy_document();
+    if(document)
+      g_async_queue_push(Zathura.Overview.documents, document);
+  }
+
+  /* the workers must never wait for a document that does not exist */
+  if(!g_async_queue_length(Zathura.Overview.documents))
+  {
+    Zathura.Overview.shared = TRUE;
+    g_async_queue_push(Zathura.Overview.documents, g_object_ref(Zathura.PDF.document));
+  }
+}
+
+void
+free_overview()
+{
+  if(Zathura.Overview.visible)
+  {
+    Zathura.Overview.visible = FALSE;
+    change_mode(NORMAL);
+    switch_view(Zathura.UI.drawing_area);
+  }
+
+  /* thumbnails that are still on their way belong to the old document */
+  g_atomic_int_inc(&(Zathura.Overview.generation));
+
+  cancel_jobs(render_thumbnail, TRUE);
+
+  if(Zathura.Overview.documents)
+  {
+    PopplerDocument* document;
+    while((document = g_async_queue_try_pop(Zathura.Overview.documents)))
+      g_object_unref(document);
+
+    g_async_queue_unref(Zathura.Overview.documents);
+  }
+  Zathura.Overview.documents = NULL;
+
+  g_hash_table_remove_all(Zathura.Overview.thumbnails);
+  g_hash_table_remove_all(Zathura.Overview.queued);
+  Zathura.Overview.used = 0;
+}
+
+void
+layout_overview()
+{
+  int width = GTK_WIDGET(Zathura.UI.view)->allocation.width;
+
+  int columns = (width - THUMBNAIL_PADDING) / (THUMBNAIL_WIDTH + THUMBNAIL_PADDING);
+  Zathura.Overview.columns = MAX(columns, 1);
+
+  int rows = (Zathura.PDF.number_of_pages + Zathura.Overview.columns - 1) / Zathura.Overview.columns;
+
+  gtk_widget_set_size_request(Zathura.UI.overview,
+      Zathura.Overview.columns * (THUMBNAIL_WIDTH + THUMBNAIL_PADDING) + THUMBNAIL_PADDING,
+      rows * (THUMBNAIL_HEIGHT + THUMBNAIL_PADDING) + THUMBNAIL_PADDING);
+}
+
+void
+request_thumbnail(int page_id)
+{
+  if(!Zathura.Overview.documents || g_hash_table_lookup(Zathura.Overview.queued, GINT_TO_POINTER(page_id + 1)))
+    return;
+
+  g_hash_table_insert(Zathura.Overview.queued, GINT_TO_POINTER(page_id + 1), GINT_TO_POINTER(TRUE));
+
+  /* the pages closest to the top of the screen come first */
+  if(!push_job(render_thumbnail, GINT_TO_POINTER(page_id + 1), PRIORITY_THUMBNAIL, NULL, compare_thumbnails))
+    render_thumbnail(GINT_TO_POINTER(page_id + 1));
+}
+
+void
+trim_thumbnails(gsize size)
+{
+  gsize budget = (gsize) THUMBNAIL_CACHE << 20;
+
+  while(g_hash_table_size(Zathura.Overview.thumbnails) && Zathura.Overview.used + size > budget)
+  {
+    Thumbnail* victim = NULL;
+    gpointer key, value;
+
+    GHashTableIter iter;
+    g_hash_table_iter_init(&iter, Zathura.Overview.thumbnails);
+    while(g_hash_table_iter_next(&iter, &key, &value))
+    {
+      Thumbnail* thumbnail = (Thumbnail*) value;
+      if(!victim || thumbnail->last_used < victim->last_used)
+        victim = thumbnail;
+    }
+
+    Zathura.Overview.used -= victim->size;
+    g_hash_table_remove(Zathura.Overview.thumbnails, GINT_TO_POINTER(victim->page));
+  }
+}
+
+void
+free_thumbnail(gpointer data)
+{
+  Thumbnail* thumbnail = (Thumbnail*) data;
+
+  if(thumbnail->surface)
+    cairo_surface_destroy(thumbnail->surface);
+  free(thumbnail);
+}
+
+gint
+compare_thumbnails(gconstpointer a, gconstpointer b, gpointer data)
+{
+  /* the pages closest to the top of the screen come first */
+  int first = g_atomic_int_get(&(Zathura.Overview.first));
+
+  return ABS(GPOINTER_TO_INT(a) - 1 - first) - ABS(GPOINTER_TO_INT(b) - 1 - first);
+}
+
+/* thread implementation */
+void*
+search(void* parameter)
+{
+  Argument* argument = (Argument*) parameter;
+
+  static char* search_item;
+  static int direction;
+  static int next_page = 0;
+  int page_counter;
+  GList* results = NULL;
+  GList* list    = NULL;
+
+  if(argument->data)
+    search_item = g_strdup((char*) argument->data);
+
+  /* search document */
+  if(argument->n)
+    direction = (argument->n == BACKWARD) ? -1 : 1;
+
+  free_argument(argument);
+
+  g_static_mutex_lock(&(Zathura.Lock.document_lock));
+  if(!Zathura.PDF.document || !search_item || !strlen(search_item))
+  {
+    g_static_mutex_unlock(&(Zathura.Lock.document_lock));
+    g_static_mutex_lock(&(Zathura.Lock.search_lock));
+    Zathura.Thread.search_thread_running = FALSE;
+    g_static_mutex_unlock(&(Zathura.Lock.search_lock));
+    return NULL;
+  }
+  g_static_mutex_unlock(&(Zathura.Lock.document_lock));
+
+  int number_of_pages = Zathura.PDF.number_of_pages;
+  int page_number     = Zathura.PDF.page_number;
+
+  for(page_counter = 1; page_counter <= Zathura.PDF.number_of_pages; page_counter++)
+  {
+    g_static_mutex_lock(&(Zathura.Lock.search_lock));
+    if(Zathura.Thread.search_thread_running == FALSE)
+    {
+      g_static_mutex_unlock(&(Zathura.Lock.search_lock));
+      return NULL;
+    }
+    g_static_mutex_unlock(&(Zathura.Lock.search_lock));
+
+    next_page = (number_of_pages + page_number +
+        page_counter * direction) % number_of_pages;
+
+    g_static_mutex_lock(&(Zathura.Lock.pdflib_lock));
+    PopplerPage* page = poppler_document_get_page(Zathura.PDF.document, next_page);
+    g_static_mutex_unlock(&(Zathura.Lock.pdflib_lock));
+
+    if(!page)
+      break;
+
+    g_static_mutex_lock(&(Zathura.Lock.pdflib_lock));
+    results = poppler_page_find_text(page, search_item);
+    g_static_mutex_unlock(&(Zathura.Lock.pdflib_lock));
+
+    if(results)
+      break;
+  }
+
+  /* draw results */
+  if(results)
+  {
+    gdk_threads_enter();
+
+    set_page(next_page);
+
+    for(list = results; list && list->data; list = g_list_next(list))
+      highlight_result(next_page, (PopplerRectangle*) list->data);
+
+    gdk_threads_leave();
+  }
+
+  g_static_mutex_lock(&(Zathura.Lock.search_lock));
+  Zathura.Thread.search_thread_running = FALSE;
+  g_static_mutex_unlock(&(Zathura.Lock.search_lock));
+
+  return NULL;
+}
+
+void*
+load_document(void* parameter)
+{
+  Loader* loader = (Loader*) parameter;
+
+  /* a document that has been closed recently is taken over as it is,
+   * everything else is read and parsed */
+  if(loader->input || loader->refresh || !take_cached_document(loader))
+    parse_document(loader);
+
+  /* the start page is the first one the user gets to see */
+  g_static_mutex_lock(&(Zathura.Lock.pdflib_lock));
+  if(loader->document)
+  {
+    loader->number_of_pages = poppler_document_get_n_pages(loader->document);
+
+    if(loader->start_page < 0 || loader->start_page >= loader->number_of_pages)
+      loader->start_page = 0;
+
+    if(loader->number_of_pages > 0)
+      loader->page = poppler_document_get_page(loader->document, loader->start_page);
+  }
+  g_static_mutex_unlock(&(Zathura.Lock.pdflib_lock));
+
+  gdk_threads_add_idle(cb_document_loaded, loader);
+
+  return NULL;
+}
+
+void
+serve_client(gpointer data, gpointer user_data)
+{
+  int fd = GPOINTER_TO_INT(data) - 1;
+
+  FILE* stream = fdopen(fd, "r");
+  if(!stream)
+  {
+    close(fd);
+    return;
+  }
+
+  /* one request per line until the client hangs up */
+  char*  line      = NULL;
+  size_t line_size = 0;
+
+  while(getline(&line, &line_size, stream) != -1)
+  {
+    if(!serve_request(fd, g_strchomp(line)))
+      break;
+  }
+
+  free(line);
+  fclose(stream);
+}
+
+void*
+render_thumbnail(void* parameter)
+{
+  Thumbnail* thumbnail  = malloc(sizeof(Thumbnail));
+  thumbnail->page       = GPOINTER_TO_INT(parameter) - 1;
+  thumbnail->generation = g_atomic_int_get(&(Zathura.Overview.generation));
+  thumbnail->surface    = NULL;
+  thumbnail->size       = 0;
+  thumbnail->last_used  = 0;
+
+  /* pages that were scrolled out of sight while waiting are skipped */
+  int margin = g_atomic_int_get(&(Zathura.Overview.columns)) * 2;
+  if(thumbnail->page < g_atomic_int_get(&(Zathura.Overview.first)) - margin ||
+      thumbnail->page > g_atomic_int_get(&(Zathura.Overview.last)) + margin)
+  {
+    gdk_threads_add_idle(cb_thumbnail_ready, thumbnail);
+    return NULL;
+  }
+
+  GStaticMutex* lock = Zathura.Overview.shared ? &(Zathura.Lock.pdflib_lock) : NULL;
+  PopplerDocument* document = g_async_queue_pop(Zathura.Overview.documents);
+
+  if(lock)
+    g_static_mutex_lock(lock);
+  PopplerPage* page = poppler_document_get_page(document, thumbnail->page);
+  if(lock)
+    g_static_mutex_unlock(lock);
+
+  if(page)
+  {
+    double page_width, page_height;
+
+    if(lock)
+      g_static_mutex_lock(lock);
+    poppler_page_get_size(page, &page_width, &page_height);
+    if(lock)
+      g_static_mutex_unlock(lock);
+
+    /* the page fits into its cell of the grid */
+    int scale = MIN(THUMBNAIL_WIDTH / page_width, THUMBNAIL_HEIGHT / page_height) * 100;
+    cairo_surface_t* surface = render_page(page, MAX(scale, 1), 0, lock, NULL);
+
+    cairo_surface_t* gray = gray_surface(surface);
+    if(gray)
+    {
+      cairo_surface_destroy(surface);
+      surface = gray;
+    }
+
+    thumbnail->surface = surface;
+    thumbnail->size    = (gsize) cairo_image_surface_get_stride(surface) * cairo_image_surface_get_height(surface);
+
+    if(lock)
+      g_static_mutex_lock(lock);
+    g_object_unref(page);
+    if(lock)
+      g_static_mutex_unlock(lock);
+  }
+
+  g_async_queue_push(Zathura.Overview.documents, document);
+
+  gdk_threads_add_idle(cb_thumbnail_ready, thumbnail);
+
+  return NULL;
+}
+
+void*
+run_jobs(void* parameter)
+{
+  g_mutex_lock(Zathura.Scheduler.lock);
+
+  while(TRUE)
+  {
+    Job* job = next_job();
+    if(!job)
+    {
+      g_cond_wait(Zathura.Scheduler.wake, Zathura.Scheduler.lock);
+      continue;
+    }
+
+    Zathura.Scheduler.running = g_list_prepend(Zathura.Scheduler.running, job);
+    g_mutex_unlock(Zathura.Scheduler.lock);
+
+    job->function(job->data);
+
+    g_mutex_lock(Zathura.Scheduler.lock);
+    Zathura.Scheduler.running = g_list_remove(Zathura.Scheduler.running, job);
+    Zathura.Scheduler.done[job->priority - PRIORITY_VISIBLE]++;
+    free(job);
+
+    g_cond_broadcast(Zathura.Scheduler.finished);
+  }
+
+  return NULL;
+}
+
+void*
+prefetch_page(void* parameter)
+{
+  Prefetch* prefetch = (Prefetch*) parameter;
+
+  /* replays are not timed, their cost is not recorded */
+  if(prefetch->recording)
+    prefetch->surface = replay_page(prefetch->source, prefetch->recording, prefetch->scale, prefetch->rotate);
+  else
+    prefetch->surface = render_page(prefetch->source, prefetch->scale, prefetch->rotate,
+        &(Zathura.Lock.pdflib_lock), &(prefetch->time));
+
+  /* the cache belongs to the main loop */
+  gdk_threads_add_idle(cb_prefetched, prefetch);
+
+  return NULL;
+}
+
+void*
+render_tile(void* parameter)
+{
+  Tile* tile = (Tile*) parameter;
+
+  PopplerPage* page = poppler_document_get_page(tile->document, tile->page);
+  cairo_t* cairo    = cairo_create(tile->surface);
+  GTimer* timer     = g_timer_new();
+
+  cairo_set_source_rgb(cairo, 1, 1, 1);
+  cairo_paint(cairo);
+
+  /* the band only shows its own rows of the page */
+  cairo_translate(cairo, 0, -tile->y);
+  transform_page(cairo, tile->scale / 100.0, tile->rotate, tile->width, tile->height);
+
+  if(page)
+  {
+    poppler_page_render(page, cairo);
+    g_object_unref(page);
+  }
+
+  cairo_destroy(cairo);
+
+  tile->time = g_timer_elapsed(timer, NULL);
+  g_timer_destroy(timer);
+
+  return NULL;
+}
+
+void*
+render_batch(void* parameter)
+{
+  Batch* batch = (Batch*) parameter;
+
+  PopplerDocument* document = poppler_document_new_from_data(batch->mapping->data, batch->mapping->length,
+      NULL, NULL);
+  if(!document)
+    return NULL;
+
+  /* the pages are handed out one at a time, so slow pages do not stall a worker's share */
+  int index;
+  while((index = g_atomic_int_exchange_and_add(&(batch->next), 1)) < batch->number_of_pages)
+  {
+    int page_id       = batch->pages[index];
+    PopplerPage* page = poppler_document_get_page(document, page_id);
+    if(!page)
+      continue;
+
+    cairo_surface_t* surface = render_page(page, batch->scale, batch->rotate, NULL, NULL);
+
+    if(Zathura.Global.recolor)
+      recolor_surface(surface);
+
+    char* file = g_strdup_printf("%s/page-%04d.png", batch->directory, page_id + 1);
+
+    if(cairo_surface_write_to_png(surface, file) == CAIRO_STATUS_SUCCESS)
+      g_atomic_int_inc(&(batch->rendered));
+    else
+      fprintf(stderr, "zathura: Could not write %s\n", file);
+
+    g_free(file);
+    cairo_surface_destroy(surface);
+    g_object_unref(page);
+  }
+
+  g_object_unref(document);
+
+  return NULL;
+}
+
+void*
+write_disk_raster(void* parameter)
+{
+  DiskRaster* raster       = (DiskRaster*) parameter;
+  cairo_surface_t* surface = raster->surface;
+  guchar* image            = cairo_image_surface_get_data(surface);
+
+  DiskHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, DISK_MAGIC, sizeof(header.magic));
+  header.format       = cairo_image_surface_get_format(surface);
+  header.width        = cairo_image_surface_get_width(surface);
+  header.height       = cairo_image_surface_get_height(surface);
+  header.stride       = cairo_image_surface_get_stride(surface);
+  header.render_scale = raster->render_scale;
+  header.length       = (guint64) header.stride * header.height;
+  header.checksum     = raster_checksum(image, header.length);
+
+  /* the file is written under another name first, so nobody maps half a raster */
+  char* temporary = g_strconcat(raster->path, ".tmp", NULL);
+  FILE* file      = fopen(temporary, "wb");
+
+  if(file)
+  {
+    gboolean written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+      fwrite(image, 1, header.length, file) == header.length;
+
+    if(fclose(file) == 0 && written && rename(temporary, raster->path) == 0)
+      trim_disk_cache(sizeof(header) + header.length);
+    else
+      unlink(temporary);
+  }
+
+  g_free(temporary);
+  g_free(raster->path);
+  cairo_surface_destroy(surface);
+  free(raster);
+
+  return NULL;
+}
+
+/* shortcut implementation */
+void
+sc_abort(Argument* argument)
+{
+  /* Clear buffer */
+  if(Zathura.Global.buffer)
+  {
+    g_string_free(Zathura.Global.buffer, TRUE);
+    Zathura.Global.buffer = NULL;
+    gtk_label_set_markup((GtkLabel*) Zathura.Global.status_buffer, "");
+  }
+
+  /* Set back to normal mode */
+  Zathura.Overview.visible = FALSE;
+  change_mode(NORMAL);
+  switch_view(Zathura.UI.drawing_area);
+}
+
+void
+sc_adjust_window(Argument* argument)
+{
+  if(!Zathura.PDF.document)
+    return;
+
+  Zathura.Global.adjust_mode = argument->n;
+
+  GtkAdjustment* adjustment;
+  double view_size;
+  double page_width;
+  double page_height;
+
+  if(argument->n == ADJUST_BESTFIT || argument->n == ADJUST_SCREEN)
+    adjustment = gtk_scrolled_window_get_vadjustment(Zathura.UI.view);
+  else if(argument->n == ADJUST_WIDTH)
+    adjustment = gtk_scrolled_window_get_hadjustment(Zathura.UI.view);
+  else
+    return;
+
+  view_size  = gtk_adjustment_get_page_size(adjustment);
+
+  /* both pages of a spread are fitted together */
+  double scale = Zathura.PDF.scale;
+  Zathura.PDF.scale = 100;
+  get_view_size(Zathura.PDF.page_number, &page_width, &page_height);
+  Zathura.PDF.scale = scale;
+
+  if(argument->n == ADJUST_BESTFIT)
+    Zathura.PDF.scale = (view_size / page_height) * 100;
+  else if(argument->n == ADJUST_SCREEN)
+  {
+    /* the whole page is shown in both directions */
+    double view_width = gtk_adjustment_get_page_size(gtk_scrolled_window_get_hadjustment(Zathura.UI.view));
+    Zathura.PDF.scale = MIN(view_size / page_height, view_width / page_width) * 100;
+  }
+  else
+    Zathura.PDF.scale = (view_size / page_width) * 100;
+
+  draw(Zathura.PDF.page_number);
+}
+
+void
+sc_change_buffer(Argument* argument)
+{
+  if(!Zathura.Global.buffer)
+    return;
+
+  int buffer_length = Zathura.Global.buffer->len;
+
+  if(argument->n == DELETE_LAST)
+  {
+    if((buffer_length - 1) == 0)
+    {
+      g_string_free(Zathura.Global.buffer, TRUE);
+      Zathura.Global.buffer = NULL;
+      gtk_label_set_markup((GtkLabel*) Zathura.Global.status_buffer, "");
+    }
+    else
+    {
+      GString* temp = g_string_new_len(Zathura.Global.buffer->str, buffer_length - 1);
+      g_string_free(Zathura.Global.buffer, TRUE);
+      Zathura.Global.buffer = temp;
+      gtk_label_set_markup((GtkLabel*) Zathura.Global.status_buffer, Zathura.Global.buffer->str);
+    }
+  }
+
+}
+
+void
+sc_change_mode(Argument* argument)
+{
+  if(argument)
+    change_mode(argument->n);
+}
+
+void 
+sc_focus_inputbar(Argument* argument)
+{
+  if(argument->data)
+  {
+    notify(DEFAULT, argument->data);
+    gtk_widget_grab_focus(GTK_WIDGET(Zathura.UI.inputbar));
+    gtk_editable_set_position(GTK_EDITABLE(Zathura.UI.inputbar), -1);
+  }
+}
+
+void
+sc_follow(Argument* argument)
+{
+  if(!Zathura.PDF.document)
+    return;
+
+  int number_of_links = 0, link_id = 1;
+
+  /* the hints are numbered across both pages of a spread */
+  int pages[2];
+  spread_pages(Zathura.PDF.page_number, &pages[0], &pages[1]);
+
+  GList* link_lists[2] = { NULL, NULL };
+
+  int i;
+  g_static_mutex_lock(&(Zathura.Lock.pdflib_lock));
+  for(i = 0; i < 2 && pages[i] != -1; i++)
+    link_lists[i] = g_list_reverse(poppler_page_get_link_mapping(Zathura.PDF.pages[pages[i]]->page));
+  g_static_mutex_unlock(&(Zathura.Lock.pdflib_lock));
+
+  if((number_of_links = g_list_length(link_lists[0]) + g_list_length(link_lists[1])) <= 0)
+    return;
+
+  for(i = 0; i < 2 && pages[i] != -1; i++)
+  {
+    /* the hints go on the same copy of the page as the highlights */
+    detach_surface(pages[i]);
+
+    cairo_t *cairo = cairo_create(*page_surface(pages[i]));
+    cairo_select_font_face(cairo, font, CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_BOLD);
+    cairo_set_font_size(cairo, 10);
+
+    GList *links;
+    for(links = link_lists[i]; links; links = g_list_next(links))
+    {
+      PopplerLinkMapping *link_mapping = (PopplerLinkMapping*) links->data;
+      PopplerRectangle* link_rectangle = &link_mapping->area;
+      PopplerAction            *action = link_mapping->action;
+
+      /* only handle URI and internal links */
+      if(action->type == POPPLER_ACTION_URI || action->type == POPPLER_ACTION_GOTO_DEST)
+      {
+        highlight_result(pages[i], link_rectangle);
+
+        /* draw text */
+        char label[16];
+        snprintf(label, sizeof(label), "%i", link_id++);
+
+        cairo_move_to(cairo, link_rectangle->x1 + 1, link_rectangle->y1 - 1);
+        cairo_show_text(cairo, label);
+      }
+    }
+
+    cairo_destroy(cairo);
+
+    if(link_lists[i])
+      poppler_page_free_link_mapping(link_lists[i]);
+  }
+
+  gtk_widget_queue_draw(Zathura.UI.drawing_area);
+
+  /* replace default inputbar handler */
+  g_signal_handler_disconnect((gpointer) Zathura.UI.inputbar, Zathura.Handler.inputbar_activate);
+  Zathura.Handler.inputbar_activate = g_signal_connect(G_OBJECT(Zathura.UI.inputbar), "activate", G_CALLBACK(cb_inputbar_form_activate), NULL);
+
+  argument->data = "Follow hint: ";
+  sc_focus_inputbar(argument);
+}
+
+void
+sc_navigate(Argument* argument)
+{
+  if(!Zathura.PDF.document)
+    return;
+
+  int number_of_pages = Zathura.PDF.number_of_pages;
+  int new_page = Zathura.PDF.page_number;
+
+  /* spreads are turned as a whole */
+  int left, right;
+  spread_pages(new_page, &left, &right);
+
+  if(argument->n == NEXT)
+    new_page = (((right != -1) ? right : left) + number_of_pages + 1) % number_of_pages;
+  else if(argument->n == PREVIOUS)
+  {
+    spread_pages((left + number_of_pages - 1) % number_of_pages, &left, &right);
+    new_page = left;
+  }
+
+  set_page(new_page);
+  update_status();
+}
+
+void
+sc_recolor(Argument* argument)
+{
+  Zathura.Global.recolor = !Zathura.Global.recolor;
+  draw(Zathura.PDF.page_number);
+}
+
+void
+sc_rotate(Argument* argument)
+{
+  Zathura.PDF.rotate = (Zathura.PDF.rotate + 90) % 360;
+
+  draw(Zathura.PDF.page_number);
+}
+
+void
+sc_scroll(Argument* argument)
+{
+  GtkAdjustment* adjustment;
+
+  if( (argument->n == LEFT) || (argument->n == RIGHT) )
+    adjustment = gtk_scrolled_window_get_hadjustment(Zathura.UI.view);
+  else
+    adjustment = gtk_scrolled_window_get_vadjustment(Zathura.UI.view);
+
+  gdouble view_size  = gtk_adjustment_get_page_size(adjustment);
+  gdouble value      = gtk_adjustment_get_value(adjustment);
+  gdouble max        = gtk_adjustment_get_upper(adjustment) - view_size;
+
+  if( (argument->n == LEFT) || (argument->n == UP))
+    gtk_adjustment_set_value(adjustment, (value - SCROLL_STEP) < 0 ? 0 : (value - SCROLL_STEP));
+  else if (argument->n == TOP)
+    gtk_adjustment_set_value(adjustment, 0);
+  else if(argument->n == BOTTOM)
+    gtk_adjustment_set_value(adjustment, max);
+  else
+    gtk_adjustment_set_value(adjustment, (value + SCROLL_STEP) > max ? max : (value + SCROLL_STEP));
+
+  update_status();
+}
+
+void
+sc_search(Argument* argument)
+{
+  /* a running search is stopped first, it might be waiting for the gdk lock */
+  g_static_mutex_lock(&(Zathura.Lock.search_lock));
+  Zathura.Thread.search_thread_running = FALSE;
+  g_static_mutex_unlock(&(Zathura.Lock.search_lock));
+
+  gdk_threads_leave();
+  cancel_jobs(search, TRUE);
+  gdk_threads_enter();
+
+  /* the text of the inputbar does not live as long as the job */
+  Argument* job = malloc(sizeof(Argument));
+  job->n        = argument->n;
+  job->data     = argument->data ? g_strdup((char*) argument->data) : NULL;
+
+  g_static_mutex_lock(&(Zathura.Lock.search_lock));
+  Zathura.Thread.search_thread_running = TRUE;
+  g_static_mutex_unlock(&(Zathura.Lock.search_lock));
+
+  if(!push_job(search, job, PRIORITY_BACKGROUND, free_argument, NULL))
+  {
+    gdk_threads_leave();
+    search(job);
+    gdk_threads_enter();
+  }
+}
+
+void
+sc_switch_goto_mode(Argument* argument)
+{
+  switch(Zathura.Global.goto_mode)
+  {
+    case GOTO_LABELS:
+      Zathura.Global.goto_mode = GOTO_OFFSET;
+      break;
+    case GOTO_OFFSET:
+      Zathura.Global.goto_mode = GOTO_DEFAULT;
+      break;
+    default:
+      if(Zathura.Global.enable_labelmode)
+        Zathura.Global.goto_mode = GOTO_LABELS;
+      else
+        Zathura.Global.goto_mode = GOTO_OFFSET;
+      break;
+  }
+
+  update_status();
+}
+
+gboolean cb_index_row_activated(GtkTreeView* treeview, GtkTreePath* path,
+  GtkTreeViewColumn* column, gpointer user_data)
+{
+  GtkTreeModel  *model;
+  GtkTreeIter   iter;
+
+  g_object_get(treeview, "model", &model, NULL);
+
+  if(gtk_tree_model_get_iter(model, &iter, path))
+  {
+    PopplerAction* action;
+    PopplerDest*   destination;
+
+    gtk_tree_model_get(model, &iter, 1, &action, -1);
+    if(!action)
+      return TRUE;
+
+    if(action->type == POPPLER_ACTION_GOTO_DEST)
+    {
+      destination = action->goto_dest.dest;
+      int page_number = destination->page_num;
+
+      if(action->goto_dest.dest->type == POPPLER_DEST_NAMED)
+      {
+        PopplerDest* d = poppler_document_find_dest(Zathura.PDF.document, action->goto_dest.dest->named_dest);
+        if(d)
+        {
+          page_number = d->page_num;
+          poppler_dest_free(d);
+        }
+      }
+
+      set_page(page_number - 1);
+      update_status();
+      gtk_widget_grab_focus(GTK_WIDGET(Zathura.UI.view));
+    }
+  }
+
+  Zathura.Global.mode = NORMAL;
+  g_object_unref(model);
+
+  return TRUE;
+}
+
+void
+sc_navigate_index(Argument* argument)
+{
+  GtkTreeView *treeview = gtk_container_get_children(GTK_CONTAINER(Zathura.UI.index))->data;
+  GtkTreePath *path;
+
+  gtk_tree_view_get_cursor(treeview, &path, NULL);
+  if(!path)
+    return;
+
+  GtkTreeModel *model = gtk_tree_view_get_model(treeview);
+  GtkTreeIter   iter;
+  GtkTreeIter   child_iter;
+
+  gboolean is_valid_path = TRUE;
+
+  switch(argument->n)
+  {
+    case UP:
+      if(!gtk_tree_path_prev(path))
+        is_valid_path = gtk_tree_path_up(path);
+      else /* row above */
+      {
+        while(gtk_tree_view_row_expanded(treeview, path)) {
+          gtk_tree_model_get_iter(model, &iter, path);
+          /* select last child */
+          gtk_tree_model_iter_nth_child(model, &child_iter, &iter,
+            gtk_tree_model_iter_n_children(model, &iter)-1);
+          gtk_tree_path_free(path);
+          path = gtk_tree_model_get_path(model, &child_iter);
+        }
+      }
+      break;
+    case COLLAPSE:
+      if(!gtk_tree_view_collapse_row(treeview, path)
+        && gtk_tree_path_get_depth(path) > 1)
+      {
+        gtk_tree_path_up(path);
+        gtk_tree_view_collapse_row(treeview, path);
+      }
+      break;
+    case DOWN:
+      if(gtk_tree_view_row_expanded(treeview, path))
+        gtk_tree_path_down(path);
+      else
+      {
+        do
+        {
+          gtk_tree_model_get_iter(model, &iter, path);
+          if (gtk_tree_model_iter_next(model, &iter))
+          {
+            path = gtk_tree_model_get_path(model, &iter);
+            break;
+          }
+        }
+        while((is_valid_path = (gtk_tree_path_get_depth(path) > 1))
+          && gtk_tree_path_up(path));
+      }
+      break;
+    case EXPAND:
+      if(gtk_tree_view_expand_row(treeview, path, FALSE))
+        gtk_tree_path_down(path);
+      break;
+    case SELECT:
+      cb_index_row_activated(treeview, path, NULL, NULL);
+      return;
+  }
+
+  if (is_valid_path)
+    gtk_tree_view_set_cursor(treeview, path, NULL, FALSE);
+
+  gtk_tree_path_free(path);
+}
+
+void
+sc_toggle_index(Argument* argument)
+{
+  if(!Zathura.PDF.document)
+    return;
+
+  GtkWidget        *treeview;
+  GtkTreeModel     *model;
+  GtkCellRenderer  *renderer;
+  PopplerIndexIter *iter;
+
+  if(!Zathura.UI.index)
+  {
+    Zathura.UI.index = gtk_scrolled_window_new (NULL, NULL);
+    gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(Zathura.UI.index),
+        GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
+
+    if((iter = poppler_index_iter_new(Zathura.PDF.document)))
+    {
+      model = GTK_TREE_MODEL(gtk_tree_store_new(2, G_TYPE_STRING, G_TYPE_POINTER));
+      g_static_mutex_lock(&(Zathura.Lock.pdflib_lock));
+      build_index(model, NULL, iter);
+      g_static_mutex_unlock(&(Zathura.Lock.pdflib_lock));
+      poppler_index_iter_free(iter);
+    }
+    else
+    {
+      notify(WARNING, "This document does not contain any index");
+      Zathura.UI.index = NULL;
+      return;
+    }
+
+    treeview = gtk_tree_view_new_with_model (model);
+    g_object_unref(model);
+    renderer = gtk_cell_renderer_text_new();
+    gtk_tree_view_insert_column_with_attributes(GTK_TREE_VIEW (treeview), 0, "Title",
+        renderer, "markup", 0, NULL);
+    gtk_tree_view_set_headers_visible(GTK_TREE_VIEW(treeview), FALSE);
+    g_object_set(G_OBJECT(renderer), "ellipsize", PANGO_ELLIPSIZE_END, NULL);
+    g_object_set(G_OBJECT(gtk_tree_view_get_column(GTK_TREE_VIEW(treeview), 0)), "expand", TRUE, NULL);
+
+    gtk_tree_view_set_cursor(GTK_TREE_VIEW(treeview), gtk_tree_path_new_first(), NULL, FALSE);
+    g_signal_connect(G_OBJECT(treeview), "row-activated", G_CALLBACK(cb_index_row_activated), NULL);
+
+    gtk_container_add (GTK_CONTAINER (Zathura.UI.index), treeview);
+    gtk_widget_show (treeview);
+    gtk_widget_show(Zathura.UI.index);
+  }
+
+  static gboolean show = FALSE;
+  if(!show)
+  {
+    switch_view(Zathura.UI.index);
+    Zathura.Global.mode = INDEX;
+  }
+  else
+  {
+    switch_view(Zathura.UI.drawing_area);
+    Zathura.Global.mode = NORMAL;
+  }
+
+  show = !show;
+}
+
+void
+sc_toggle_overview(Argument* argument)
+{
+  if(!Zathura.PDF.document)
+    return;
+
+  if(Zathura.Overview.visible)
+  {
+    Zathura.Overview.visible = FALSE;
+    Zathura.Global.mode      = NORMAL;
+    set_page(Zathura.PDF.page_number);
+    return;
+  }
+
+  open_overview();
+
+  Zathura.Overview.visible  = TRUE;
+  Zathura.Overview.selected = Zathura.PDF.page_number;
+  Zathura.Global.mode       = OVERVIEW;
+
+  switch_view(Zathura.UI.overview);
+  layout_overview();
+
+  Argument arg;
+  arg.n = 0;
+  sc_navigate_overview(&arg);
+}
+
+void
+sc_navigate_overview(Argument* argument)
+{
+  int selected = Zathura.Overview.selected;
+
+  switch(argument->n)
+  {
+    case LEFT:
+      selected--;
+      break;
+    case RIGHT:
+      selected++;
+      break;
+    case UP:
+      selected -= Zathura.Overview.columns;
+      break;
+    case DOWN:
+      selected += Zathura.Overview.columns;
+      break;
+    case SELECT:
+      Zathura.Overview.visible = FALSE;
+      Zathura.Global.mode      = NORMAL;
+      set_page(selected);
+      update_status();
+      return;
+  }
+
+  if(selected < 0 || selected >= Zathura.PDF.number_of_pages)
+    return;
+
+  Zathura.Overview.selected = selected;
+
+  /* the selected thumbnail is kept on the screen */
+  int y = THUMBNAIL_PADDING + (selected / Zathura.Overview.columns) * (THUMBNAIL_HEIGHT + THUMBNAIL_PADDING);
+  gtk_adjustment_clamp_page(gtk_scrolled_window_get_vadjustment(Zathura.UI.view),
+      y - THUMBNAIL_PADDING, y + THUMBNAIL_HEIGHT + THUMBNAIL_PADDING);
+
+  gtk_widget_queue_draw(Zathura.UI.overview);
+}
+
+void
+sc_toggle_inputbar(Argument* argument)
+{
+  if(GTK_WIDGET_VISIBLE(GTK_WIDGET(Zathura.UI.inputbar)))
+    gtk_widget_hide(GTK_WIDGET(Zathura.UI.inputbar));
+  else
+    gtk_widget_show(GTK_WIDGET(Zathura.UI.inputbar));
+}
+
+void
+sc_toggle_statusbar(Argument* argument)
+{
+  if(GTK_WIDGET_VISIBLE(GTK_WIDGET(Zathura.UI.statusbar)))
+    gtk_widget_hide(GTK_WIDGET(Zathura.UI.statusbar));
+  else
+    gtk_widget_show(GTK_WIDGET(Zathura.UI.statusbar));
+}
+
+void
+sc_toggle_presentation(Argument* argument)
+{
+  if(!Zathura.Presentation.active)
+  {
+    if(!Zathura.PDF.document)
+      return;
+
+    Zathura.Presentation.active      = TRUE;
+    Zathura.Presentation.adjust_mode = Zathura.Global.adjust_mode;
+    Zathura.Presentation.scale       = Zathura.PDF.scale;
+    Zathura.Presentation.statusbar   = GTK_WIDGET_VISIBLE(GTK_WIDGET(Zathura.UI.statusbar));
+    Zathura.Presentation.inputbar    = GTK_WIDGET_VISIBLE(GTK_WIDGET(Zathura.UI.inputbar));
+
+    gtk_widget_hide(GTK_WIDGET(Zathura.UI.statusbar));
+    gtk_widget_hide(GTK_WIDGET(Zathura.UI.inputbar));
+    gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(Zathura.UI.view), GTK_POLICY_NEVER, GTK_POLICY_NEVER);
+    gtk_window_fullscreen(Zathura.UI.window);
+
+    /* the page is fitted again once the window has its new size */
+    Argument arg;
+    arg.n = ADJUST_SCREEN;
+    sc_adjust_window(&arg);
+    return;
+  }
+
+  Zathura.Presentation.active = FALSE;
+
+  gtk_window_unfullscreen(Zathura.UI.window);
+
+  #if SHOW_SCROLLBARS
+    gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(Zathura.UI.view), GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
+  #endif
+
+  if(Zathura.Presentation.statusbar)
+    gtk_widget_show(GTK_WIDGET(Zathura.UI.statusbar));
+  if(Zathura.Presentation.inputbar)
+    gtk_widget_show(GTK_WIDGET(Zathura.UI.inputbar));
+
+  Zathura.Global.adjust_mode = Zathura.Presentation.adjust_mode;
+  Zathura.PDF.scale          = Zathura.Presentation.scale;
+
+  draw(Zathura.PDF.page_number);
+}
+
+void
+sc_quit(Argument* argument)
+{
+  cb_destroy(NULL, NULL);
+}
+
+/* inputbar shortcut declarations */
+void
+isc_abort(Argument* argument)
+{
+  Argument arg = { HIDE };
+  isc_completion(&arg);
+
+  notify(DEFAULT, "");
+  gtk_widget_grab_focus(GTK_WIDGET(Zathura.UI.view));
+}
+
+void
+isc_command_history(Argument* argument)
+{
+  static int current = 0;
+  int        length  = g_list_length(Zathura.Global.history);
+
+  if(length > 0)
+  {
+    if(argument->n == NEXT)
+      current = (length + current + 1) % length;
+    else
+      current = (length + current - 1) % length;
+
+    gchar* command = (gchar*) g_list_nth_data(Zathura.Global.history, current);
+    notify(DEFAULT, command);
+    gtk_widget_grab_focus(GTK_WIDGET(Zathura.UI.inputbar));
+    gtk_editable_set_position(GTK_EDITABLE(Zathura.UI.inputbar), -1);
+  }
+}
+
+void 
+isc_completion(Argument* argument)
+{
+  gchar *input      = gtk_editable_get_chars(GTK_EDITABLE(Zathura.UI.inputbar), 1, -1);
+  gchar  identifier = gtk_editable_get_chars(GTK_EDITABLE(Zathura.UI.inputbar), 0,  1)[0];
+  int    length     = strlen(input);
+ 
+  if(!length && !identifier)
+    return;
+
+  /* get current information*/
+  char* first_space = strstr(input, " ");
+  char* current_command;
+  char* current_parameter;
+  int   current_command_length;
+  int   current_parameter_length;
+
+  if(!first_space)
+  {
+    current_command          = input;
+    current_command_length   = length;
+    current_parameter        = NULL;
+    current_parameter_length = 0;
+  }
+  else
+  {
+    int offset               = abs(input - first_space);
+    current_command          = g_strndup(input, offset);
+    current_command_length   = strlen(current_command);
+    current_parameter        = input + offset + 1;
+    current_parameter_length = strlen(current_parameter);
+  }
+
+  /* if the identifier does not match the command sign and
+   * the completion should not be hidden, leave this function */
+  if((identifier != ':') && (argument->n != HIDE))
+    return;
+
+  /* static elements */
+  static GtkBox        *results = NULL;
+  static CompletionRow *rows    = NULL;
+
+  static int current_item = 0;
+  static int n_items      = 0;
+
+  static char *previous_command   = NULL;
+  static char *previous_parameter = NULL;
+  static int   previous_id        = 0;
+  static int   previous_length    = 0;
+
+  static gboolean command_mode = TRUE;
+
+  /* delete old list iff
+   *   the completion should be hidden
+   *   the current command differs from the previous one
+   *   the current parameter differs from the previous one
+   */
+  if( (argument->n == HIDE) ||
+      (current_parameter && previous_parameter && strcmp(current_parameter, previous_parameter)) ||
+      (current_command && previous_command && strcmp(current_command, previous_command)) ||
+      (previous_length != length)
+    )
+  {
+    if(results)
+      gtk_widget_destroy(GTK_WIDGET(results));
+
+    results = NULL;
+
+    if(rows)
+      free(rows);
+
+    rows         = NULL;
+    current_item = 0;
+    n_items      = 0;
+    command_mode = TRUE;
+
+    if(argument->n == HIDE)
+      return;
+  }
+
+  /* create new list iff
+   *  there is no current list
+   *  the current command differs from the previous one
+   *  the current parameter differs from the previous one
+   */
+  if( (!results) )
+  {
+    results = GTK_BOX(gtk_vbox_new(FALSE, 0));
+
+    /* create list based on parameters iff
+     *  there is a current parameter given
+     *  there is an old list with commands
+     *  the current command does not differ from the previous one
+     *  the current command has an completion function
+     */
+    if( (previous_command) && (current_parameter) && !strcmp(current_command, previous_command) )
+    {
+      if(previous_id < 0 || !commands[previous_id].completion)
+        return;
+
+      Completion *result = commands[previous_id].completion(current_parameter);
+
+      if(!result || !result->groups)
+        return;
+
+      command_mode               = FALSE;
+      CompletionGroup* group     = NULL;
+      CompletionElement* element = NULL;
+
+      rows = malloc(sizeof(CompletionRow));
+
+      for(group = result->groups; group != NULL; group = group->next)
+      {
+        int group_elements = 0;
+
+        for(element = group->elements; element != NULL; element = element->next)
+        {
+          if( (element->value) &&
+              (current_parameter_length <= strlen(element->value)) && !strncmp(current_parameter, element->value, current_parameter_length)
+            )
+          {
+            rows = realloc(rows, (n_items + 1) * sizeof(CompletionRow));
+            rows[n_items].command     = element->value;
+            rows[n_items].description = element->description;
+            rows[n_items].command_id  = previous_id;
+            rows[n_items].is_group    = FALSE;
+            rows[n_items++].row       = GTK_WIDGET(createCompletionRow(results, element->value, element->description, FALSE));
+            group_elements++;
+          }
+        }
+
+        if(group->value && group_elements > 0)
+        {
+          rows = realloc(rows, (n_items + 1) * sizeof(CompletionRow));
+          rows[n_items].command     = group->value;
+          rows[n_items].description = NULL;
+          rows[n_items].command_id  = -1;
+          rows[n_items].is_group    = TRUE;
+          rows[n_items].row       = GTK_WIDGET(createCompletionRow(results, group->value, NULL, TRUE));
+
+          /* Swap group element with first element of the list */
+          CompletionRow temp = rows[n_items - group_elements];
+          gtk_box_reorder_child(results, rows[n_items].row, n_items - group_elements);
+          rows[n_items - group_elements] = rows[n_items];
+          rows[n_items] = temp;
+
+          n_items++;
+        }
+      }
+
+      /* clean up */
+      group = result->groups;
+
+      while(group)
+      {
+        element = group->elements;
+        while(element)
+        {
+          CompletionElement* ne = element->next;
+          free(element);
+          element = ne;
+        }
+
+        CompletionGroup *ng = group->next;
+        free(group);
+        group = ng;
+      }
+    }
+    /* create list based on commands */
+    else
+    {
+      int i = 0;
+      command_mode = TRUE;
+
+      rows = malloc(LENGTH(commands) * sizeof(CompletionRow));
+
+      for(i = 0; i < LENGTH(commands); i++)
+      {
+        int abbr_length = commands[i].abbr ? strlen(commands[i].abbr) : 0;
+        int cmd_length  = commands[i].command ? strlen(commands[i].command) : 0;
+
+        /* add command to list iff
+         *  the current command would match the command
+         *  the current command would match the abbreviation
+         */
+        if( ((current_command_length <= cmd_length)  && !strncmp(current_command, commands[i].command, current_command_length)) ||
+            ((current_command_length <= abbr_length) && !strncmp(current_command, commands[i].abbr,    current_command_length))
+          )
+        {
+          rows[n_items].command     = commands[i].command;
+          rows[n_items].description = commands[i].description;
+          rows[n_items].command_id  = i;
+          rows[n_items].is_group    = FALSE;
+          rows[n_items++].row       = GTK_WIDGET(createCompletionRow(results, commands[i].command, commands[i].description, FALSE));
+        }
+      }
+
+      rows = realloc(rows, n_items * sizeof(CompletionRow));
+    }
+
+    gtk_box_pack_start(Zathura.UI.box, GTK_WIDGET(results), FALSE, FALSE, 0);
+    gtk_widget_show_all(GTK_WIDGET(Zathura.UI.window));
+
+    current_item = (argument->n == NEXT) ? -1 : 0;
+  }
+
+  /* update coloring iff
+   *  there is a list with items
+   */
+  if( (results) && (n_items > 0) )
+  {
+    setCompletionRowColor(results, NORMAL, current_item);
+    char* temp;
+    int i = 0, next_group = 0;
+
+    for(i = 0; i < n_items; i++)
+    {
+      if(argument->n == NEXT || argument->n == NEXT_GROUP)
+        current_item = (current_item + n_items + 1) % n_items;
+      else if(argument->n == PREVIOUS || argument->n == PREVIOUS_GROUP)
+        current_item = (current_item + n_items - 1) % n_items;
+
+      if(rows[current_item].is_group)
+      {
+        if(!command_mode && (argument->n == NEXT_GROUP || argument->n == PREVIOUS_GROUP))
+          next_group = 1;
+        continue;
+      }
+      else
+      {
+        if(!command_mode && (next_group == 0) && (argument->n == NEXT_GROUP || argument->n == PREVIOUS_GROUP))
+          continue;
+        break;
+      }
+    }
+
+    setCompletionRowColor(results, HIGHLIGHT, current_item);
+
+    if(command_mode)
+    {
+      char* cp = (current_parameter) ? g_strconcat(" ", current_parameter, NULL) : 0;
+      temp = g_strconcat(":", rows[current_item].command, cp, NULL);
+    }
+    else
+    {
+      temp = g_strconcat(":", previous_command, " ", rows[current_item].command, NULL);
+    }
+
+    gtk_entry_set_text(Zathura.UI.inputbar, temp);
+    gtk_editable_set_position(GTK_EDITABLE(Zathura.UI.inputbar), -1);
+    g_free(temp);
+
+    previous_command   = (command_mode) ? rows[current_item].command : current_command;
+    previous_parameter = (command_mode) ? current_parameter : rows[current_item].command;
+    previous_length    = strlen(previous_command) + ((command_mode) ? (length - current_command_length) : (strlen(previous_parameter) + 1));
+    previous_id        = rows[current_item].command_id;
+  }
+}
+
+void
+isc_string_manipulation(Argument* argument)
+{
+  if(argument->n == DELETE_LAST_WORD)
+  {
+    gchar *input  = gtk_editable_get_chars(GTK_EDITABLE(Zathura.UI.inputbar), 0, -1);
+    int    length = strlen(input);
+    int    i      = 0;
+
+    for(i = length; i > 0; i--)
+    {
+      if( (input[i] == ' ') ||
+          (input[i] == '/') )
+      {
+        if(i == (length - 1))
+          continue;
+
+        i = (input[i] == ' ') ? (i - 1) : i;
+        break;
+      }
+    }
+
+    notify(DEFAULT, g_strndup(input, i + 1));
+    gtk_editable_set_position(GTK_EDITABLE(Zathura.UI.inputbar), -1);
+  }
+}
+
+/* command implementation */
+gboolean
+cmd_bookmark(int argc, char** argv)
+{
+  if(!Zathura.PDF.document || argc < 1)
+    return TRUE;
+
+  /* get id */
+  int i;
+  GString *id = g_string_new("");
+
+  for(i = 0; i < argc; i++)
+  {
+    if(i != 0)
+      id = g_string_append_c(id, ' ');
+
+    id = g_string_append(id, argv[i]);
+  }
+
+  /* check for existing bookmark to overwrite */
+  for(i = 0; i < Zathura.Bookmarks.number_of_bookmarks; i++)
+  {
+    if(!strcmp(id->str, Zathura.Bookmarks.bookmarks[i].id))
+    {
+      Zathura.Bookmarks.bookmarks[i].page = Zathura.PDF.page_number;
+      return TRUE;
+    }
+  }
+
+  /* add new bookmark */
+  Zathura.Bookmarks.bookmarks = realloc(Zathura.Bookmarks.bookmarks, 
+      (Zathura.Bookmarks.number_of_bookmarks + 1) * sizeof(Bookmark)); 
+
+  Zathura.Bookmarks.bookmarks[Zathura.Bookmarks.number_of_bookmarks].id   = id->str;
+  Zathura.Bookmarks.bookmarks[Zathura.Bookmarks.number_of_bookmarks].page = Zathura.PDF.page_number;
+  Zathura.Bookmarks.number_of_bookmarks++;
+
+  return TRUE;
+}
+
+gboolean
+cmd_bench(int argc, char** argv)
+{
+  if(!Zathura.PDF.document)
+    return FALSE;
+
+  int page_id       = Zathura.PDF.page_number;
+  PopplerPage* page = Zathura.PDF.pages[page_id]->page;
+  GTimer* timer     = g_timer_new();
+
+  /* a fresh render of the current page */
+  cairo_surface_t* surface = render_page(page, Zathura.PDF.scale, Zathura.PDF.rotate, &(Zathura.Lock.pdflib_lock), NULL);
+  double render = g_timer_elapsed(timer, NULL);
+  cairo_surface_destroy(surface);
+
+  /* the display list is built once and replayed afterwards */
+  g_timer_start(timer);
+  cairo_surface_t* recording = get_recording(page_id, TRUE);
+  double record = g_timer_elapsed(timer, NULL);
+
+  if(!recording)
+  {
+    notify(WARNING, "The page does not fit into the recording cache");
+    g_timer_destroy(timer);
+    return FALSE;
+  }
+
+  g_timer_start(timer);
+  surface = replay_page(page, recording, Zathura.PDF.scale, Zathura.PDF.rotate);
+  double replay = g_timer_elapsed(timer, NULL);
+  cairo_surface_destroy(surface);
+
+  g_timer_destroy(timer);
+
+  char* text = g_strdup_printf("render %.1f ms, record %.1f ms, replay %.1f ms (%.1fx)",
+      render * 1000, record * 1000, replay * 1000, (replay > 0) ? render / replay : 0.0);
+  notify(DEFAULT, text);
+  g_free(text);
+
+  return FALSE;
+}
+
+gboolean
+cmd_cache(int argc, char** argv)
+{
+  char* text = g_strdup_printf("%d pages, %.1f/%d MiB, %u hits, %u shared - packed: %d pages, %.1f/%d MiB, %u hits, %u misses"
+      " - pool: %d buffers, %.1f MiB, %ld faults per page - recorded: %d pages, %.1f/%d MiB"
+      " - disk: %.1f/%d MiB, %u hits",
+      g_list_length(Zathura.Cache.rasters), Zathura.Cache.used / 1048576.0, Zathura.Cache.size, Zathura.Cache.hits,
+      Zathura.Cache.shared,
+      g_list_length(Zathura.Cache.packed), Zathura.Cache.packed_used / 1048576.0, Zathura.Cache.packed_size,
+      Zathura.Cache.packed_hits, Zathura.Cache.packed_misses,
+      g_list_length(Zathura.Pool.buffers), Zathura.Pool.size / 1048576.0,
+      Zathura.Pool.turns ? Zathura.Pool.faults / Zathura.Pool.turns : 0,
+      g_list_length(Zathura.Cache.recordings), Zathura.Cache.recordings_used / 1048576.0,
+      Zathura.Cache.recording_size, Zathura.Disk.used / 1048576.0, Zathura.Disk.size, Zathura.Disk.hits);
+
+  notify(DEFAULT, text);
+  g_free(text);
+
+  return FALSE;
+}
+
+gboolean
+cmd_jobs(int argc, char** argv)
+{
+  if(!Zathura.Scheduler.count)
+  {
+    notify(WARNING, "There are no workers");
+    return FALSE;
+  }
+
+  g_mutex_lock(Zathura.Scheduler.lock);
+
+  GQueue** queues     = Zathura.Scheduler.queues;
+  unsigned int* done = Zathura.Scheduler.done;
+
+  char* text = g_strdup_printf("waiting: %d visible, %d prefetch, %d thumbnails, %d background"
+      " - %d of %d workers busy - done: %u visible, %u prefetch, %u thumbnails, %u background",
+      g_queue_get_length(queues[0]), g_queue_get_length(queues[1]), g_queue_get_length(queues[2]),
+      g_queue_get_length(queues[3]), g_list_length(Zathura.Scheduler.running), Zathura.Scheduler.count,
+      done[0], done[1], done[2], done[3]);
+
+  g_mutex_unlock(Zathura.Scheduler.lock);
+
+  notify(DEFAULT, text);
+  g_free(text);
+
+  return FALSE;
+}
+
+gboolean
+cmd_open_bookmark(int argc, char** argv)
+{
+  if(!Zathura.PDF.document || argc < 1)
+    return TRUE;
+  
+  /* get id */
+  int i;
+  GString *id = g_string_new("");
+
+  for(i = 0; i < argc; i++)
+  {
+    if(i != 0)
+      id = g_string_append_c(id, ' ');
+
+    id = g_string_append(id, argv[i]);
+  }
+
+  /* find bookmark */
+  for(i = 0; i < Zathura.Bookmarks.number_of_bookmarks; i++)
+  {
+    if(!strcmp(id->str, Zathura.Bookmarks.bookmarks[i].id))
+    {
+      set_page(Zathura.Bookmarks.bookmarks[i].page);
+      return TRUE;
+    }
+  }
+
+  notify(WARNING, "No matching bookmark found");
+  return FALSE;
+}
+
+gboolean
+cmd_close(int argc, char** argv)
+{
+  /* abort loading */
+  Zathura.State.goto_page = -1;
+
+  if(Zathura.State.loading)
+  {
+    Zathura.State.loading  = FALSE;
+    Zathura.State.filename = (char*) DEFAULT_TEXT;
+    Zathura.State.pages    = "";
+    update_status();
+
+    /* the page that was mapped from the disk */
+    if(!Zathura.PDF.document && Zathura.PDF.surface)
+    {
+      cairo_surface_destroy(Zathura.PDF.surface);
+      Zathura.PDF.surface = NULL;
+      invalidate_pixmap();
+    }
+  }
+
+  if(Zathura.Thread.load_idle)
+    g_source_remove(Zathura.Thread.load_idle);
+  Zathura.Thread.load_idle = 0;
+  Zathura.Thread.load_id++;
+
+  /* stream */
+  if(Zathura.Stream.update)
+    g_source_remove(Zathura.Stream.update);
+
+  g_free(Zathura.Stream.file);
+  g_free(Zathura.Stream.password);
+  Zathura.Stream.file     = NULL;
+  Zathura.Stream.password = NULL;
+  Zathura.Stream.update   = 0;
+  Zathura.Stream.parsing  = FALSE;
+
+  /* inotify */
+  if(Zathura.Inotify.fd != -1 && Zathura.Inotify.wd != -1)
+    inotify_rm_watch(Zathura.Inotify.fd, Zathura.Inotify.wd);
+
+  Zathura.Inotify.wd = -1;
+
+  if(Zathura.Inotify.reload)
+    g_source_remove(Zathura.Inotify.reload);
+
+  Zathura.Inotify.reload = 0;
+
+  /* the view is shown from the disk when the document is opened again */
+  if(Zathura.Disk.document && Zathura.PDF.document)
+  {
+    char* name = g_strconcat(Zathura.Disk.document, ".last", NULL);
+    char* last = g_build_filename(Zathura.Disk.directory, name, NULL);
+    char* view = g_strdup_printf("%d %d %d\n", Zathura.PDF.page_number, Zathura.PDF.scale, Zathura.PDF.rotate);
+
+    g_file_set_contents(last, view, -1, NULL);
+
+    g_free(view);
+    g_free(last);
+    g_free(name);
+  }
+
+  g_free(Zathura.Disk.document);
+  Zathura.Disk.document = NULL;
+
+  if(!Zathura.PDF.document)
+  {
+    if(argc != -1)
+      notify(ERROR, "No file has been opened");
+    return FALSE;
+  }
+
+  /* save bookmarks */
+  save_bookmarks();
+  clear_bookmarks();
+  save_costs();
+  clear_costs();
+
+  /* reset values, the parsed document is kept in case it is opened again */
+  free_pages();
+  clear_rasters();
+
+  if(Zathura.PDF.surface)
+    cairo_surface_destroy(Zathura.PDF.surface);
+  if(Zathura.PDF.spread)
+    cairo_surface_destroy(Zathura.PDF.spread);
+  Zathura.PDF.surface = NULL;
+  Zathura.PDF.spread  = NULL;
+  invalidate_pixmap();
+
+  /* the workers render from copies of the document, which share its mapping */
+  free_tiles();
+  free_overview();
+  cancel_prefetch();
+
+  /* only a server is asked to open the same files again */
+  if(DOCUMENT_CACHE > 0 && Zathura.PDF.mtime && Zathura.Server.fd != -1)
+    cache_document();
+  else
+  {
+    g_object_unref(Zathura.PDF.document);
+    unmap_file(Zathura.PDF.mapping);
+  }
+
+  Zathura.PDF.mapping = NULL;
+
+  Zathura.State.pages         = "";
+  Zathura.State.filename      = (char*) DEFAULT_TEXT;
+
+  g_static_mutex_lock(&(Zathura.Lock.document_lock));
+  Zathura.PDF.document        = NULL;
+  g_static_mutex_unlock(&(Zathura.Lock.document_lock));
+  Zathura.PDF.file            = "";
+  Zathura.PDF.password        = "";
+  Zathura.PDF.page_number     = 0;
+  Zathura.PDF.number_of_pages = 0;
+  Zathura.PDF.scale           = 0;
+  Zathura.PDF.rotate          = 0;
+  Zathura.PDF.page_offset     = 0;
+  Zathura.PDF.mtime           = 0;
+  Zathura.PDF.file_size       = 0;
+
+  /* destroy index */
+  if(Zathura.UI.index)
+  {
+    gtk_widget_destroy(Zathura.UI.index);
+    Zathura.UI.index = NULL;
+  }
+
+  /* destroy information */
+  if(Zathura.UI.information)
+  {
+    gtk_widget_destroy(Zathura.UI.information);
+    Zathura.UI.information = NULL;
+  }
+
+  /* free markers */
+  if(Zathura.Marker.markers)
+    free(Zathura.Marker.markers);
+  Zathura.Marker.number_of_markers =  0;
+  Zathura.Marker.last              = -1;
+
+  update_status();
+
+  return TRUE;
+}
+
+gboolean
+cmd_correct_offset(int argc, char** argv)
+{
+  if(!Zathura.PDF.document || argc == 0)
+    return TRUE;
+
+  Zathura.PDF.page_offset = (Zathura.PDF.page_number + 1) - atoi(argv[0]);
+
+  if(Zathura.PDF.page_offset != 0)
+    Zathura.Global.goto_mode = GOTO_OFFSET;
+  else
+    Zathura.Global.goto_mode = GOTO_MODE;
+
+  update_status();
+
+  return TRUE;
+}
+
+gboolean
+cmd_delete_bookmark(int argc, char** argv)
+{
+  if(!Zathura.PDF.document || argc < 1)
+    return TRUE;
+
+  /* get id */
+  int i;
+  GString *id = g_string_new("");
+
+  for(i = 0; i < argc; i++)
+  {
+    if(i != 0)
+      id = g_string_append_c(id, ' ');
+
+    id = g_string_append(id, argv[i]);
+  }
+
+  /* check for bookmark to delete */
+  for(i = 0; i < Zathura.Bookmarks.number_of_bookmarks; i++)
+  {
+    if(!strcmp(id->str, Zathura.Bookmarks.bookmarks[i].id))
+    {
+      /* update bookmarks, the removal is journaled on close */
+      g_free(Zathura.Bookmarks.bookmarks[i].id);
+      Zathura.Bookmarks.bookmarks[i].id   = Zathura.Bookmarks.bookmarks[Zathura.Bookmarks.number_of_bookmarks - 1].id;
+      Zathura.Bookmarks.bookmarks[i].page = Zathura.Bookmarks.bookmarks[Zathura.Bookmarks.number_of_bookmarks - 1].page;
+      Zathura.Bookmarks.bookmarks = realloc(Zathura.Bookmarks.bookmarks,
+          Zathura.Bookmarks.number_of_bookmarks * sizeof(Bookmark));
+
+      Zathura.Bookmarks.number_of_bookmarks--;
+
+      return TRUE;
+    }
+  }
+
+  return TRUE;
+}
+
+gboolean
+cmd_export(int argc, char** argv)
+{
+  if(argc == 0 || !Zathura.PDF.document)
+    return TRUE;
+
+  if(argc < 2)
+  {
+    notify(WARNING, "No export path specified");
+    return FALSE;
+  }
+
+  /* export images */
+  if(!strcmp(argv[0], "images"))
+  {
+    int page_number;
+    for(page_number = 0; page_number < Zathura.PDF.number_of_pages; page_number++)
+    {
+      GList           *image_list;
+      GList           *images;
+      cairo_surface_t *image;
+
+      g_static_mutex_lock(&(Zathura.Lock.pdflib_lock));
+      image_list = poppler_page_get_image_mapping(load_page(page_number)->page);
+      g_static_mutex_unlock(&(Zathura.Lock.pdflib_lock));
+
+      if(!g_list_length(image_list))
+      {
+        notify(WARNING, "This document does not contain any images");
+        return FALSE;
+      }
+
+      for(images = image_list; images; images = g_list_next(images))
+      {
+        PopplerImageMapping *image_mapping;
+        PopplerRectangle     image_field;
+        gint                 image_id;
+        char*                file;
+        char*                filename;
+
+        image_mapping = (PopplerImageMapping*) images->data;
+        image_field   = image_mapping->area;
+        image_id      = image_mapping->image_id;
+
+        g_static_mutex_lock(&(Zathura.Lock.pdflib_lock));
+        image     = poppler_page_get_image(Zathura.PDF.pages[page_number]->page, image_id);
+        g_static_mutex_unlock(&(Zathura.Lock.pdflib_lock));
+
+        if(!image)
+          continue;
+
+        filename  = g_strdup_printf("%s_p%i_i%i.png", Zathura.PDF.file, page_number + 1, image_id);
+
+        if(argv[1][0] == '~')
+        {
+          file = malloc(((int) strlen(filename) + (int) strlen(argv[1]) 
+            + (int) strlen(getenv("HOME")) - 1) * sizeof(char));
+          file = g_strdup_printf("%s%s%s", getenv("HOME"), argv[1] + 1, filename);
+        }
+        else
+          file = g_strdup_printf("%s%s", argv[1], filename);
+
+        cairo_surface_write_to_png(image, file);
+
+        g_free(file);
+      }
+    }
+  }
+  else if(!strcmp(argv[0], "attachments"))
+  {
+    g_static_mutex_lock(&(Zathura.Lock.pdflib_lock));
+    if(!poppler_document_has_attachments(Zathura.PDF.document))
+    {
+      notify(WARNING, "PDF file has no attachments");
+      g_static_mutex_unlock(&(Zathura.Lock.pdflib_lock));
+      return FALSE;
+    }
+
+    GList *attachment_list = poppler_document_get_attachments(Zathura.PDF.document);
+    g_static_mutex_unlock(&(Zathura.Lock.pdflib_lock));
+
+    GList *attachments;
+    char  *file;
+
+    for(attachments = attachment_list; attachments; attachments = g_list_next(attachments))
+    {
+      PopplerAttachment *attachment = (PopplerAttachment*) attachments->data;
+
+      if(argv[1][0] == '~')
+      {
+        file = malloc(((int) strlen(attachment->name) + (int) strlen(argv[1])
+          + (int) strlen(getenv("HOME")) - 1) * sizeof(char));
+        file = g_strdup_printf("%s%s%s", getenv("HOME"), argv[1] + 1, attachment->name);
+      }
+      else
+        file = g_strdup_printf("%s%s", argv[1], attachment->name);
+
+      g_static_mutex_lock(&(Zathura.Lock.pdflib_lock));
+      poppler_attachment_save(attachment, file, NULL);
+      g_static_mutex_unlock(&(Zathura.Lock.pdflib_lock));
+
+      g_free(file);
+    }
+  }
+
+  return TRUE;
+}
+
+gboolean
+cmd_goto(int argc, char** argv)
+{
+  if(argc < 1)
+    return TRUE;
+
+  int page = atoi(argv[0]) - 1;
+
+  /* jump as soon as the document has been loaded */
+  if(Zathura.State.loading)
+  {
+    Zathura.State.goto_page = page;
+    return TRUE;
+  }
+
+  if(!Zathura.PDF.document)
+    return TRUE;
+
+  set_page(page);
+  update_status();
+
+  return TRUE;
+}
+
+gboolean
+cmd_info(int argc, char** argv)
+{
+  if(!Zathura.PDF.document)
+    return TRUE;
+
+  static gboolean visible = FALSE;
+
+  if(!Zathura.UI.information)
+  {
+    GtkListStore      *list;
+    GtkTreeIter        iter;
+    GtkCellRenderer   *renderer;
+    GtkTreeSelection  *selection;
+
+    list = gtk_list_store_new(2, G_TYPE_STRING, G_TYPE_STRING);
+
+    /* read document information */
+    gchar *title,   *author;
+    gchar *subject, *keywords;
+    gchar *creator, *producer;
+    GTime  creation_date, modification_date;
+
+    g_object_get(Zathura.PDF.document,
+        "title",         &title,
+        "author",        &author,
+        "subject",       &subject,
+        "keywords",      &keywords,
+        "creator",       &creator,
+        "producer",      &producer,
+        "creation-date", &creation_date,
+        "mod-date",      &modification_date,
+        NULL);
+
+    /* append information to list */
+    gtk_list_store_append(list, &iter);
+    gtk_list_store_set(list, &iter, 0,  "Author",   1, author   ? author   : "", -1);
+    gtk_list_store_append(list, &iter);
+    gtk_list_store_set(list, &iter, 0,  "Title",    1, title    ? title    : "", -1);
+    gtk_list_store_append(list, &iter);
+    gtk_list_store_set(list, &iter, 0,  "Subject",  1, subject  ? subject  : "", -1);
+    gtk_list_store_append(list, &iter);
+    gtk_list_store_set(list, &iter, 0,  "Keywords", 1, keywords ? keywords : "", -1);
+    gtk_list_store_append(list, &iter);
+    gtk_list_store_set(list, &iter, 0,  "Creator",  1, creator  ? creator  : "", -1);
+    gtk_list_store_append(list, &iter);
+    gtk_list_store_set(list, &iter, 0,  "Producer", 1, producer ? producer : "", -1);
+
+    Zathura.UI.information = gtk_tree_view_new_with_model(GTK_TREE_MODEL(list));
+    renderer = gtk_cell_renderer_text_new();
+
+    gtk_tree_view_insert_column_with_attributes(GTK_TREE_VIEW(Zathura.UI.information), -1,
+      "Name", renderer, "text", 0, NULL);
+    gtk_tree_view_insert_column_with_attributes(GTK_TREE_VIEW(Zathura.UI.information), -1,
+      "Value", renderer, "text", 1, NULL);
+
+    selection = gtk_tree_view_get_selection(GTK_TREE_VIEW(Zathura.UI.information));
+    gtk_tree_selection_set_mode(selection, GTK_SELECTION_SINGLE);
+
+    gtk_widget_show_all(Zathura.UI.information);
+  }
+
+  if(!visible)
+    switch_view(Zathura.UI.information);
+  else
+    switch_view(Zathura.UI.drawing_area);
+
+  visible = !visible;
+
+  return FALSE;
+}
+
+gboolean
+cmd_open(int argc, char** argv)
+{
+  if(argc == 0 || strlen(argv[0]) == 0)
+    return FALSE;
+
+  /* assembly the arguments back to one string */
+  int i = 0;
+  GString *filepath = g_string_new("");
+  for(i = 0; i < argc; i++)
+  {
+    if(i != 0)
+      filepath = g_string_append_c(filepath, ' ');
+
+    filepath = g_string_append(filepath, argv[i]);
+  }
+
+  return open_file(filepath->str, Zathura.PDF.password);
+}
+
+gboolean
+cmd_print(int argc, char** argv)
+{
+  if(!Zathura.PDF.document)
+    return TRUE;
+
+  if(argc == 0)
+  {
+    notify(WARNING, "No printer specified");
+    return FALSE;
+  }
+
+  char* printer = argv[0];
+  char* sites   = (argc == 2) ? argv[1] : g_strdup_printf("%i", Zathura.PDF.number_of_pages);
+  char* print_command = g_strdup_printf(PRINT_COMMAND, printer, sites, Zathura.PDF.file);
+  system(print_command);
+
+  return TRUE;
+}
+
+gboolean
+cmd_reload(int argc, char** argv)
+{
+  if(!Zathura.PDF.document)
+    return TRUE;
+
+  if(Zathura.Inotify.reload)
+    g_source_remove(Zathura.Inotify.reload);
+
+  cb_reload_file(NULL);
+
+  return TRUE;
+}
+
+gboolean
+cmd_rotate(int argc, char** argv)
+{
+  return TRUE;
+}
+
+gboolean
+cmd_set(int argc, char** argv)
+{
+  if(argc <= 0 || argc >= 3)
+    return FALSE;
+
+  int i;
+  for(i = 0; i < LENGTH(settings); i++)
+  {
+    if(!strcmp(argv[0], settings[i].name))
+    {
+      /* check var type */
+      if(settings[i].type == 'b')
+      {
+        gboolean *x = (gboolean*) (settings[i].variable);
+        *x = !(*x);
+
+        if(argv[1])
+        {
+          if(!strcmp(argv[1], "false") || !strcmp(argv[1], "0"))
+            *x = FALSE;
+          else
+            *x = TRUE;
+        }
+      }
+      else if(settings[i].type == 'i')
+      {
+        if(argc != 2)
+          return FALSE;
+
+        int *x = (int*) (settings[i].variable);
+        if(argv[1])
+          *x = atoi(argv[1]);
+      }
+      else if(settings[i].type == 's')
+      {
+        if(argc != 2)
+          return FALSE;
+
+        char **x = (char**) settings[i].variable;
+        if(argv[1])
+          *x = argv[1];
+      }
+      else if(settings[i].type == 'c')
+      {
+        if(argc != 2)
+          return FALSE;
+
+        char *x = (char*) (settings[i].variable);
+        if(argv[1])
+          *x = argv[1][0];
+      }
+
+      /* render */
+      if(settings[i].render)
+      {
+        if(!Zathura.PDF.document)
+          return FALSE;
+
+        draw(Zathura.PDF.page_number);
+      }
+    }
+  }
+
+  update_status();
+  return TRUE;
+}
+
+gboolean
+cmd_quit(int argc, char** argv)
+{
+  cb_destroy(NULL, NULL);
+  return TRUE;
+}
+
+gboolean
+cmd_save(int argc, char** argv)
+{
+  if(argc == 0 || !Zathura.PDF.document)
+    return TRUE;
+
+  char* path = g_strdup_printf("file://%s", argv[0]);
+  g_static_mutex_lock(&(Zathura.Lock.pdflib_lock));
+  poppler_document_save(Zathura.PDF.document, path, NULL);
+  g_static_mutex_unlock(&(Zathura.Lock.pdflib_lock));
+  g_free(path);
+
+  return TRUE;
+}
+
+/* completion command implementation */
+Completion*
+cc_bookmark(char* input)
+{
+  /* init completion group */
+  Completion *completion = malloc(sizeof(Completion));
+  CompletionGroup* group = malloc(sizeof(CompletionGroup));
+
+  group->value    = NULL;
+  group->next     = NULL;
+  group->elements = NULL;
+
+  completion->groups = group;
+  CompletionElement *last_element = NULL;
+  int element_counter = 0;
+  int i = 0;
+  int input_length = input ? strlen(input) : 0;
+
+  for(i = 0; i < Zathura.Bookmarks.number_of_bookmarks; i++)
+  {
+    if( (input_length <= strlen(Zathura.Bookmarks.bookmarks[i].id)) &&
+          !strncmp(input, Zathura.Bookmarks.bookmarks[i].id, input_length) )
+    {
+      CompletionElement* el = malloc(sizeof(CompletionElement));
+      el->value = Zathura.Bookmarks.bookmarks[i].id;
+      el->description = g_strdup_printf("Page: %d", Zathura.Bookmarks.bookmarks[i].page);
+      el->next = NULL;
+
+      if(element_counter++ != 0)
+        last_element->next = el;
+      else
+        group->elements = el;
+
+      last_element = el;
+    }
+  }
+
+  return completion;
+}
+
+Completion*
+cc_export(char* input)
+{
+  /* init completion group */
+  Completion *completion = malloc(sizeof(Completion));
+  CompletionGroup* group = malloc(sizeof(CompletionGroup));
+
+  group->value    = NULL;
+  group->next     = NULL;
+  group->elements = NULL;
+
+  completion->groups = group;
+
+  /* export images */
+  CompletionElement *export_images = malloc(sizeof(CompletionElement));
+  export_images->value = "images";
+  export_images->description = "Export images";
+  export_images->next = NULL;
+
+  /* export attachmants */
+  CompletionElement *export_attachments = malloc(sizeof(CompletionElement));
+  export_attachments->value = "attachments";
+  export_attachments->description = "Export attachments";
+  export_attachments->next = NULL;
+
+  /* connect */
+  group->elements = export_attachments;
+  export_attachments->next = export_images;
+
+  return completion;
+}
+
+Completion*
+cc_open(char* input)
+{
+  /* init completion group */
+  Completion *completion = malloc(sizeof(Completion));
+  CompletionGroup* group = malloc(sizeof(CompletionGroup));
+
+  group->value    = NULL;
+  group->next     = NULL;
+  group->elements = NULL;
+
+  completion->groups = group;
+
+  /* read dir */
+  char* path        = "/";
+  char* file        = "";
+  int   file_length = 0;
+
+  /* ~ */
+  if(input[0] == '~')
+  {
+    char *file = g_strdup_printf(":open %s/%s", getenv("HOME"), input + 1);
+    gtk_entry_set_text(Zathura.UI.inputbar, file);
+    gtk_editable_set_position(GTK_EDITABLE(Zathura.UI.inputbar), -1);
+    return NULL;
+  }
+
+  /* parse input string */
+  if(input && strlen(input) > 0)
+  {
+    char* path_temp = dirname(strdup(input));
+    char* file_temp = basename(strdup(input));
+    char  last_char = input[strlen(input) - 1];
+
+    if( !strcmp(path_temp, "/") && !strcmp(file_temp, "/") )
+      file = "";
+    else if( !strcmp(path_temp, "/") && strcmp(file_temp, "/") && last_char != '/')
+      file = file_temp;
+    else if( !strcmp(path_temp, "/") && strcmp(file_temp, "/") && last_char == '/')
+      path = g_strdup_printf("/%s/", file_temp);
+    else if(last_char == '/')
+      path = input;
+    else
+    {
+      path = g_strdup_printf("%s/", path_temp);
+      file = file_temp;
+    }
+  }
+
+  file_length = strlen(file);
+
+  /* open directory */
+  GDir* dir = g_dir_open(path, 0, NULL);
+  if(!dir)
+    return NULL;
+
+  /* create element list */
+  CompletionElement *last_element = NULL;
+  char* name            = NULL;
+  int   element_counter = 0;
+
+  while((name = (char*) g_dir_read_name(dir)) != NULL)
+  {
+    char* d_name   = g_filename_display_name(name);
+    int   d_length = strlen(d_name);
+
+    if( ((file_length <= d_length) && !strncmp(file, d_name, file_length)) ||
+        (file_length == 0) )
+    {
+      CompletionElement* el = malloc(sizeof(CompletionElement));
+      el->value = g_strdup_printf("%s%s", path, d_name);
+      el->description = NULL;
+      el->next = NULL;
+
+      if(element_counter++ != 0)
+        last_element->next = el;
+      else
+        group->elements = el;
+
+      last_element = el;
+    }
+  }
+
+  g_dir_close(dir);
+
+  return completion;
+}
+
+Completion*
+cc_print(char* input)
+{
+  /* init completion group */
+  Completion *completion = malloc(sizeof(Completion));
+  CompletionGroup* group = malloc(sizeof(CompletionGroup));
+
+  group->value    = NULL;
+  group->next     = NULL;
+  group->elements = NULL;
+
+  completion->groups = group;
+  CompletionElement *last_element = NULL;
+  int element_counter = 0;
+  int input_length = input ? strlen(input) : 0;
+
+  /* read printers */
+  char *current_line = NULL, current_char;
+  int count = 0;
+  FILE *fp;
+
+  fp = popen(LIST_PRINTER_COMMAND, "r");
+
+  if(!fp)
+  {
+    free(completion);
+    free(group);
+    return NULL;
+  }
+
+  while((current_char = fgetc(fp)) != EOF)
+  {
+    if(!current_line)
+      current_line = malloc(sizeof(char));
+
+    current_line = realloc(current_line, (count + 1) * sizeof(char));
+
+    if(current_char != '\n')
+      current_line[count++] = current_char;
+    else
+    {
+      current_line[count] = '\0';
+      int line_length = strlen(current_line);
+
+      if( (input_length <= line_length) ||
+          (!strncmp(input, current_line, input_length)) )
+      {
+        CompletionElement* el = malloc(sizeof(CompletionElement));
+        el->value       = g_strdup(current_line);
+        el->description = NULL;
+        el->next        = NULL;
+
+        if(element_counter++ != 0)
+          last_element->next = el;
+        else
+          group->elements = el;
+
+        last_element = el;
+      }
+
+      free(current_line);
+      current_line = NULL;
+      count = 0;
+    }
+  }
+
+  pclose(fp);
+
+  return completion;
+}
+
+Completion*
+cc_set(char* input)
+{
+  /* init completion group */
+  Completion *completion = malloc(sizeof(Completion));
+  CompletionGroup* group = malloc(sizeof(CompletionGroup));
+
+  group->value    = NULL;
+  group->next     = NULL;
+  group->elements = NULL;
+
+  completion->groups = group;
+  CompletionElement *last_element = NULL;
+  int element_counter = 0;
+  int i = 0;
+  int input_length = input ? strlen(input) : 0;
+
+  for(i = 0; i < LENGTH(settings); i++)
+  {
+    if( (input_length <= strlen(settings[i].name)) &&
+          !strncmp(input, settings[i].name, input_length) )
+    {
+      CompletionElement* el = malloc(sizeof(CompletionElement));
+      el->value = settings[i].name;
+      el->description = settings[i].description;
+      el->next = NULL;
+
+      if(element_counter++ != 0)
+        last_element->next = el;
+      else
+        group->elements = el;
+
+      last_element = el;
+    }
+  }
+
+  return completion;
+}
+
+/* buffer command implementation */
+void 
+bcmd_goto(char* buffer, Argument* argument)
+{
+  int b_length = strlen(buffer);
+  if(b_length < 1)
+    return;
+
+  if(!strcmp(buffer, "gg"))
+    set_page(0);
+  else if(!strcmp(buffer, "G"))
+    set_page(Zathura.PDF.number_of_pages - 1);
+  else
+  {
+    char* id = g_strndup(buffer, b_length - 1);
+    int  pid = atoi(id);
+
+    if(Zathura.Global.goto_mode == GOTO_LABELS)
+    {
+      int i;
+      for(i = 0; i < Zathura.PDF.number_of_pages; i++)
+        if(!strcmp(id, load_page(i)->label))
+          pid = Zathura.PDF.pages[i]->id;
+    }
+    else if(Zathura.Global.goto_mode == GOTO_OFFSET)
+      pid += Zathura.PDF.page_offset;
+
+    set_page(pid - 1);
+    g_free(id);
+   }
+
+  update_status();
+}
+
+void
+bcmd_scroll(char* buffer, Argument* argument)
+{
+  int b_length = strlen(buffer);
+  if(b_length < 1)
+    return;
+
+  int percentage = atoi(g_strndup(buffer, b_length - 1));
+  percentage = (percentage < 0) ? 0 : ((percentage > 100) ? 100 : percentage);
+
+  GtkAdjustment *adjustment = gtk_scrolled_window_get_vadjustment(Zathura.UI.view);
+
+  gdouble view_size  = gtk_adjustment_get_page_size(adjustment);
+  gdouble max        = gtk_adjustment_get_upper(adjustment) - view_size;
+  gdouble nvalue     = (percentage * max) / 100;
+
+  Zathura.State.scroll_percentage = percentage;
+  gtk_adjustment_set_value(adjustment, nvalue);
+  update_status();
+}
+
+void
+bcmd_zoom(char* buffer, Argument* argument)
+{
+  Zathura.Global.adjust_mode = ADJUST_NONE;
+
+  if(argument->n == ZOOM_IN)
+  {
+    if((Zathura.PDF.scale + ZOOM_STEP) <= ZOOM_MAX)
+      Zathura.PDF.scale += ZOOM_STEP;
+    else
+      Zathura.PDF.scale = ZOOM_MAX;
+  }
+  else if(argument->n == ZOOM_OUT)
+  {
+    if((Zathura.PDF.scale - ZOOM_STEP) >= ZOOM_MIN)
+      Zathura.PDF.scale -= ZOOM_STEP;
+    else
+      Zathura.PDF.scale = ZOOM_MIN;
+  }
+  else if(argument->n == ZOOM_SPECIFIC)
+  {
+    int b_length = strlen(buffer);
+    if(b_length < 1)
+      return;
 
-    /* read document information */
-    gchar *title,   *author;
-    gchar *subject, *keywords;
-    gchar *creator, *producer;
-    GTime  creation_date, modification_date;
+    int value = atoi(g_strndup(buffer, b_length - 1));
+    if(value <= ZOOM_MIN)
+      Zathura.PDF.scale = ZOOM_MIN;
+    else if(value >= ZOOM_MAX)
+      Zathura.PDF.scale = ZOOM_MAX;
+    else
+      Zathura.PDF.scale = value;
+  }
+  else
+    Zathura.PDF.scale = 100;
 
-    g_object_get(Zathura.PDF.document,
-        "title",         &title,
-        "author",        &author,
-        "subject",       &subject,
-        "keywords",      &keywords,
-        "creator",       &creator,
-        "producer",      &producer,
-        "creation-date", &creation_date,
-        "mod-date",      &modification_date,
-        NULL);
+  draw(Zathura.PDF.page_number);
+  update_status();
+}
 
-    /* append information to list */
-    gtk_list_store_append(list, &iter);
-    gtk_list_store_set(list, &iter, 0,  "Author",   1, author   ? author   : "", -1);
-    gtk_list_store_append(list, &iter);
-    gtk_list_store_set(list, &iter, 0,  "Title",    1, title    ? title    : "", -1);
-    gtk_list_store_append(list, &iter);
-    gtk_list_store_set(list, &iter, 0,  "Subject",  1, subject  ? subject  : "", -1);
-    gtk_list_store_append(list, &iter);
-    gtk_list_store_set(list, &iter, 0,  "Keywords", 1, keywords ? keywords : "", -1);
-    gtk_list_store_append(list, &iter);
-    gtk_list_store_set(list, &iter, 0,  "Creator",  1, creator  ? creator  : "", -1);
-    gtk_list_store_append(list, &iter);
-    gtk_list_store_set(list, &iter, 0,  "Producer", 1, producer ? producer : "", -1);
+/* special command implementation */
+gboolean
+scmd_search(char* input, Argument* argument)
+{
+  if(!strlen(input))
+    return TRUE;
 
-    Zathura.UI.information = gtk_tree_view_new_with_model(GTK_TREE_MODEL(list));
-    renderer = gtk_cell_renderer_text_new();
+  argument->data = input;
+  sc_search(argument);
 
-    gtk_tree_view_insert_column_with_attributes(GTK_TREE_VIEW(Zathura.UI.information), -1,
-      "Name", renderer, "text", 0, NULL);
-    gtk_tree_view_insert_column_with_attributes(GTK_TREE_VIEW(Zathura.UI.information), -1,
-      "Value", renderer, "text", 1, NULL);
+  return TRUE;
+}
 
-    selection = gtk_tree_view_get_selection(GTK_TREE_VIEW(Zathura.UI.information));
-    gtk_tree_selection_set_mode(selection, GTK_SELECTION_SINGLE);
+/* callback implementation */
+gboolean
+cb_destroy(GtkWidget* widget, gpointer data)
+{
+  pango_font_description_free(Zathura.Style.font);
 
-    gtk_widget_show_all(Zathura.UI.information);
+  if(Zathura.PDF.document)
+    cmd_close(0, NULL);
+
+  /* finish writing rendered pages to the disk, a search might need the gdk lock meanwhile */
+  gdk_threads_leave();
+  finish_jobs(write_disk_raster);
+  gdk_threads_enter();
+
+  /* clean up other variables */
+  g_free(Zathura.Bookmarks.directory);
+  g_free(Zathura.Disk.directory);
+
+  /* inotify */
+  if(Zathura.Inotify.watch)
+    g_source_remove(Zathura.Inotify.watch);
+
+  if(Zathura.Inotify.channel)
+    g_io_channel_unref(Zathura.Inotify.channel);
+
+  if(Zathura.Inotify.fd != -1)
+    close(Zathura.Inotify.fd);
+
+  /* memory pressure */
+  if(Zathura.Pressure.watch)
+    g_source_remove(Zathura.Pressure.watch);
+
+  if(Zathura.Pressure.channel)
+    g_io_channel_unref(Zathura.Pressure.channel);
+
+  if(Zathura.Pressure.fd != -1)
+    close(Zathura.Pressure.fd);
+
+  /* server */
+  if(Zathura.Server.watch)
+    g_source_remove(Zathura.Server.watch);
+
+  if(Zathura.Server.channel)
+    g_io_channel_unref(Zathura.Server.channel);
+
+  if(Zathura.Server.fd != -1)
+  {
+    close(Zathura.Server.fd);
+    unlink(Zathura.Server.socket);
   }
 
-  if(!visible)
-    switch_view(Zathura.UI.information);
+  g_free(Zathura.Server.socket);
+
+  /* documents kept for reopening */
+  GList* list;
+  for(list = Zathura.Cache.documents; list; list = g_list_next(list))
+    free_cached_document((CachedDocument*) list->data);
+  g_list_free(Zathura.Cache.documents);
+
+  clear_pool();
+
+  gtk_main_quit();
+
+  return TRUE;
+}
+
+gboolean cb_draw(GtkWidget* widget, GdkEventExpose* expose, gpointer data)
+{
+  /* while the document is parsed the last page is shown from the disk */
+  gboolean placeholder = !Zathura.PDF.document && Zathura.State.loading && Zathura.PDF.surface;
+
+  if(!Zathura.PDF.document && !placeholder)
+    return FALSE;
+
+  int page_id = Zathura.PDF.page_number;
+
+  if(!placeholder && (page_id < 0 || page_id > Zathura.PDF.number_of_pages))
+    return FALSE;
+
+  gdk_window_clear(widget->window);
+  cairo_t *cairo = gdk_cairo_create(widget->window);
+
+  double width, height;
+  if(placeholder)
+  {
+    width  = cairo_image_surface_get_width(Zathura.PDF.surface);
+    height = cairo_image_surface_get_height(Zathura.PDF.surface);
+  }
   else
-    switch_view(Zathura.UI.drawing_area);
+    get_view_size(page_id, &width, &height);
 
-  visible = !visible;
+  int window_x, window_y;
+  gdk_drawable_get_size(widget->window, &window_x, &window_y);
+
+  int offset_x, offset_y;
+
+  if (window_x > width)
+    offset_x = (window_x - width) / 2;
+  else
+    offset_x = 0;
+
+  if (window_y > height)
+    offset_y = (window_y - height) / 2;
+  else
+    offset_y = 0;
+
+
+  /* the raster is copied to the X server once, every expose after that
+   * only copies the exposed area from the pixmap to the window */
+  if(!Zathura.PDF.pixmap)
+  {
+    Zathura.PDF.pixmap = gdk_pixmap_new(widget->window, MAX((int) width, 1), MAX((int) height, 1), -1);
+    cairo_t *upload    = gdk_cairo_create(Zathura.PDF.pixmap);
+
+    /* the pages of a spread are put next to each other at their logical
+     * size, the lower one on white */
+    cairo_surface_t* surfaces[2] = { Zathura.PDF.surface, Zathura.PDF.spread };
+    double widths[2]  = { width, 0 };
+    double heights[2] = { height, 0 };
+
+    if(Zathura.PDF.spread)
+    {
+      int left, right;
+      spread_pages(page_id, &left, &right);
+      get_page_size(left,  &widths[0], &heights[0]);
+      get_page_size(right, &widths[1], &heights[1]);
+
+      cairo_set_source_rgb(upload, 1, 1, 1);
+      cairo_paint(upload);
+    }
+
+    int i;
+    for(i = 0; i < 2 && surfaces[i]; i++)
+    {
+      /* a page that did not fit into the cache budget is scaled up */
+      int surface_width  = cairo_image_surface_get_width(surfaces[i]);
+      int surface_height = cairo_image_surface_get_height(surfaces[i]);
+
+      cairo_save(upload);
+      cairo_translate(upload, i ? widths[0] : 0, 0);
+      if(surface_width != (int) widths[i] || surface_height != (int) heights[i])
+        cairo_scale(upload, (int) widths[i] / (double) surface_width, (int) heights[i] / (double) surface_height);
+
+      paint_surface(upload, surfaces[i]);
+      cairo_restore(upload);
+    }
+
+    cairo_destroy(upload);
+  }
+
+  gdk_cairo_region(cairo, expose->region);
+  cairo_clip(cairo);
+
+  gdk_cairo_set_source_pixmap(cairo, Zathura.PDF.pixmap, offset_x, offset_y);
+  cairo_paint(cairo);
+  cairo_destroy(cairo);
+
+  return TRUE;
+}
+
+gboolean
+cb_inputbar_kb_pressed(GtkWidget *widget, GdkEventKey *event, gpointer data)
+{
+  /* when the return button is pressed the inputbar is activated,
+   * so we do not handle it here */
+  if(event->keyval == GDK_Return)
+    return FALSE;
+
+  int i;
+
+  /* inputbar shortcuts */
+  for(i = 0; i < LENGTH(inputbar_shortcuts); i++)
+  {
+    if(event->keyval == inputbar_shortcuts[i].key &&
+      (((event->state & inputbar_shortcuts[i].mask) == inputbar_shortcuts[i].mask)
+       || inputbar_shortcuts[i].mask == 0))
+    {
+      inputbar_shortcuts[i].function(&(inputbar_shortcuts[i].argument));
+      return TRUE;
+    }
+  }
+
+  /* special commands */
+  char identifier = gtk_editable_get_chars(GTK_EDITABLE(Zathura.UI.inputbar), 0, 1)[0];
+  for(i = 0; i < LENGTH(special_commands); i++)
+  {
+    if((identifier == special_commands[i].identifier) &&
+       (special_commands[i].always == 1))
+    {
+      gchar *input  = gtk_editable_get_chars(GTK_EDITABLE(Zathura.UI.inputbar), 1, -1);
+      special_commands[i].function(input, &(special_commands[i].argument));
+      return FALSE;
+    }
+  }
 
   return FALSE;
 }
 
 gboolean
-cmd_open(int argc, char** argv)
+cb_inputbar_activate(GtkEntry* entry, gpointer data)
 {
-  if(argc == 0 || strlen(argv[0]) == 0)
+  gchar  *input  = gtk_editable_get_chars(GTK_EDITABLE(entry), 1, -1);
+  gchar **tokens = g_strsplit(input, " ", -1);
+  gchar *command = tokens[0];
+  int     length = g_strv_length(tokens);
+  int          i = 0;
+  gboolean  retv = FALSE;
+  gboolean  succ = FALSE;
+
+  /* no input */
+  if(length < 1)
+  {
+    isc_abort(NULL);
     return FALSE;
+  }
 
-  /* assembly the arguments back to one string */
-  int i = 0;
-  GString *filepath = g_string_new("");
-  for(i = 0; i < argc; i++)
+  /* append input to the command history */
+  Zathura.Global.history = g_list_append(Zathura.Global.history, g_strdup(gtk_entry_get_text(entry)));
+
+  /* special commands */
+  char identifier = gtk_editable_get_chars(GTK_EDITABLE(entry), 0, 1)[0];
+  for(i = 0; i < LENGTH(special_commands); i++)
   {
-    if(i != 0)
-      filepath = g_string_append_c(filepath, ' ');
+    if(identifier == special_commands[i].identifier)
+    {
+      /* special commands that are evaluated every key change are not
+       * called here */
+      if(special_commands[i].always == 1)
+      {
+        isc_abort(NULL);
+        return TRUE;
+      }
 
-    filepath = g_string_append(filepath, argv[i]);
+      retv = special_commands[i].function(input, &(special_commands[i].argument));
+      if(retv) isc_abort(NULL);
+      gtk_widget_grab_focus(GTK_WIDGET(Zathura.UI.view));
+      return TRUE;
+    }
+  }
+
+  /* search commands */
+  for(i = 0; i < LENGTH(commands); i++)
+  {
+    if((g_strcmp0(command, commands[i].command) == 0) ||
+       (g_strcmp0(command, commands[i].abbr)    == 0))
+    {
+      retv = commands[i].function(length - 1, tokens + 1);
+      succ = TRUE;
+      break;
+    }
   }
 
-  return open_file(filepath->str, Zathura.PDF.password);
+  if(retv)
+    isc_abort(NULL);
+
+  if(!succ)
+    notify(ERROR, "Unknown command.");
+
+  Argument arg = { HIDE };
+  isc_completion(&arg);
+  gtk_widget_grab_focus(GTK_WIDGET(Zathura.UI.view));
+
+  return TRUE;
 }
 
 gboolean
-cmd_print(int argc, char** argv)
+cb_inputbar_form_activate(GtkEntry* entry, gpointer data)
 {
   if(!Zathura.PDF.document)
     return TRUE;
 
-  if(argc == 0)
-  {
-    notify(WARNING, "No printer specified");
-    return FALSE;
-  }
+  int number_of_links = 0, link_id = 1, new_page_id = Zathura.PDF.page_number;
 
-  char* printer = argv[0];
-  char* sites   = (argc == 2) ? argv[1] : g_strdup_printf("%i", Zathura.PDF.number_of_pages);
-  char* print_command = g_strdup_printf(PRINT_COMMAND, printer, sites, Zathura.PDF.file);
-  system(print_command);
+  /* the hints are numbered across both pages of a spread, like in sc_follow */
+  int pages[2];
+  spread_pages(Zathura.PDF.page_number, &pages[0], &pages[1]);
 
-  return TRUE;
-}
+  GList* link_lists[2] = { NULL, NULL };
 
-gboolean
-cmd_rotate(int argc, char** argv)
-{
-  return TRUE;
-}
+  int i;
+  g_static_mutex_lock(&(Zathura.Lock.pdflib_lock));
+  for(i = 0; i < 2 && pages[i] != -1; i++)
+    link_lists[i] = g_list_reverse(poppler_page_get_link_mapping(Zathura.PDF.pages[pages[i]]->page));
+  g_static_mutex_unlock(&(Zathura.Lock.pdflib_lock));
 
-gboolean
-cmd_set(int argc, char** argv)
-{
-  if(argc <= 0 || argc >= 3)
+  if((number_of_links = g_list_length(link_lists[0]) + g_list_length(link_lists[1])) <= 0)
     return FALSE;
 
-  int i;
-  for(i = 0; i < LENGTH(settings); i++)
+  /* parse entry */
+  gchar *input = gtk_editable_get_chars(GTK_EDITABLE(entry), 1, -1);
+  gchar *token = input + strlen("Follow hint: ") - 1;
+  int li       = token ? atoi(token) : 0;
+
+  /* compare entry */
+  for(i = 0; i < 2; i++)
   {
-    if(!strcmp(argv[0], settings[i].name))
+    GList *links;
+    for(links = link_lists[i]; links; links = g_list_next(links))
     {
-      /* check var type */
-      if(settings[i].type == 'b')
-      {
-        gboolean *x = (gboolean*) (settings[i].variable);
-        *x = !(*x);
-
-        if(argv[1])
-        {
-          if(!strcmp(argv[1], "false") || !strcmp(argv[1], "0"))
-            *x = FALSE;
-          else
-            *x = TRUE;
-        }
-      }
-      else if(settings[i].type == 'i')
-      {
-        if(argc != 2)
-          return FALSE;
+      PopplerLinkMapping *link_mapping = (PopplerLinkMapping*) links->data;
+      PopplerAction            *action = link_mapping->action;
 
-        int *x = (int*) (settings[i].variable);
-        if(argv[1])
-          *x = atoi(argv[1]);
-      }
-      else if(settings[i].type == 's')
+      /* only handle URI and internal links */
+      if(action->type == POPPLER_ACTION_URI)
       {
-        if(argc != 2)
-          return FALSE;
-
-        char **x = (char**) settings[i].variable;
-        if(argv[1])
-          *x = argv[1];
+        if(li == link_id)
+          open_uri(action->uri.uri);
       }
-      else if(settings[i].type == 'c')
+      else if(action->type == POPPLER_ACTION_GOTO_DEST)
       {
-        if(argc != 2)
-          return FALSE;
-
-        char *x = (char*) (settings[i].variable);
-        if(argv[1])
-          *x = argv[1][0];
+        if(li == link_id)
+        {
+          if(action->goto_dest.dest->type == POPPLER_DEST_NAMED)
+          {
+            PopplerDest* destination = poppler_document_find_dest(Zathura.PDF.document, action->goto_dest.dest->named_dest);
+            if(destination)
+            {
+              new_page_id = destination->page_num - 1;
+              poppler_dest_free(destination);
+            }
+          }
+          else
+            new_page_id = action->goto_dest.dest->page_num - 1;
+        }
       }
+      else
+        continue;
 
-      /* render */
-      if(settings[i].render)
-      {
-        if(!Zathura.PDF.document)
-          return FALSE;
-
-        draw(Zathura.PDF.page_number);
-      }
+      link_id++;
     }
-  }
 
-  update_status();
-  return TRUE;
-}
+    if(link_lists[i])
+      poppler_page_free_link_mapping(link_lists[i]);
+  }
 
-gboolean
-cmd_quit(int argc, char** argv)
-{
-  cb_destroy(NULL, NULL);
-  return TRUE;
-}
+  g_free(input);
 
-gboolean
-cmd_save(int argc, char** argv)
-{
-  if(argc == 0 || !Zathura.PDF.document)
+  if(li <= 0 || li >= link_id)
+  {
+    set_page(Zathura.PDF.page_number);
+    isc_abort(NULL);
+    notify(WARNING, "Invalid hint");
     return TRUE;
+  }
 
-  char* path = g_strdup_printf("file://%s", argv[0]);
-  g_static_mutex_lock(&(Zathura.Lock.pdflib_lock));
-  poppler_document_save(Zathura.PDF.document, path, NULL);
-  g_static_mutex_unlock(&(Zathura.Lock.pdflib_lock));
-  g_free(path);
+  /* replace default inputbar handler */
+  g_signal_handler_disconnect((gpointer) Zathura.UI.inputbar, Zathura.Handler.inputbar_activate);
+  Zathura.Handler.inputbar_activate = g_signal_connect(G_OBJECT(Zathura.UI.inputbar), "activate", G_CALLBACK(cb_inputbar_activate), NULL);
+
+  /* reset all */
+  set_page(new_page_id);
+  isc_abort(NULL);
 
   return TRUE;
 }
 
-/* completion command implementation */
-Completion*
-cc_bookmark(char* input)
+gboolean
+cb_document_loaded(gpointer data)
 {
-  /* init completion group */
-  Completion *completion = malloc(sizeof(Completion));
-  CompletionGroup* group = malloc(sizeof(CompletionGroup));
+  Loader* loader = (Loader*) data;
 
-  group->value    = NULL;
-  group->next     = NULL;
-  group->elements = NULL;
+  /* the document has been closed or another one has been opened meanwhile */
+  if(loader->id != Zathura.Thread.load_id)
+  {
+    if(loader->page)
+      g_object_unref(loader->page);
+    if(loader->document)
+      g_object_unref(loader->document);
+    unmap_file(loader->mapping);
+  }
+  else if(!loader->document || !loader->page)
+  {
+    if(loader->document)
+      g_object_unref(loader->document);
+    unmap_file(loader->mapping);
 
-  completion->groups = group;
-  CompletionElement *last_element = NULL;
-  int element_counter = 0;
-  int i = 0;
-  int input_length = input ? strlen(input) : 0;
+    /* a streamed file may not be parseable yet, wait for more data, but
+     * a wrong password stays wrong */
+    gboolean encrypted = !loader->refresh && !loader->document && loader->error && loader->error->code == 1;
 
-  for(i = 0; i < Zathura.Bookmarks.number_of_bookmarks; i++)
-  {
-    if( (input_length <= strlen(Zathura.Bookmarks.bookmarks[i].id)) &&
-          !strncmp(input, Zathura.Bookmarks.bookmarks[i].id, input_length) )
+    if(Zathura.Stream.file && !encrypted)
     {
-      CompletionElement* el = malloc(sizeof(CompletionElement));
-      el->value = Zathura.Bookmarks.bookmarks[i].id;
-      el->description = g_strdup_printf("Page: %d", Zathura.Bookmarks.bookmarks[i].page);
-      el->next = NULL;
+      if(!loader->refresh)
+      {
+        Zathura.State.pages = "[Waiting for data...]";
+        update_status();
+      }
+    }
+    else
+    {
+      Zathura.State.loading   = FALSE;
+      Zathura.State.goto_page = -1;
+      Zathura.State.filename  = (char*) DEFAULT_TEXT;
+      Zathura.State.pages     = "";
+      update_status();
 
-      if(element_counter++ != 0)
-        last_element->next = el;
+      if(loader->document)
+        notify(ERROR, "Document does not contain any pages");
       else
-        group->elements = el;
+      {
+        char* message = (loader->error->code == 1) ? "(Use \":set password\" to set the password)" : "";
+        message = g_strdup_printf("Can not open file: %s %s", loader->error->message, message);
+        notify(ERROR, message);
+        g_free(message);
+      }
 
-      last_element = el;
+      /* inotify */
+      if(Zathura.Inotify.wd != -1)
+        inotify_rm_watch(Zathura.Inotify.fd, Zathura.Inotify.wd);
+      Zathura.Inotify.wd = -1;
+
+      /* stream */
+      if(Zathura.Stream.update)
+        g_source_remove(Zathura.Stream.update);
+
+      g_free(Zathura.Stream.file);
+      g_free(Zathura.Stream.password);
+      Zathura.Stream.file     = NULL;
+      Zathura.Stream.password = NULL;
+      Zathura.Stream.update   = 0;
+      Zathura.Stream.parsing  = FALSE;
     }
   }
+  else
+  {
+    /* replace the document that has been read so far */
+    if(loader->refresh)
+    {
+      free_pages();
+
+      g_static_mutex_lock(&(Zathura.Lock.document_lock));
+      g_object_unref(Zathura.PDF.document);
+      g_static_mutex_unlock(&(Zathura.Lock.document_lock));
+      free_tiles();
+      free_overview();
+      cancel_prefetch();
+      unmap_file(Zathura.PDF.mapping);
+      clear_rasters();
+
+      /* the outline may have grown as well */
+      if(Zathura.UI.index)
+      {
+        gtk_widget_destroy(Zathura.UI.index);
+        Zathura.UI.index = NULL;
+      }
+    }
+    else
+    {
+      Zathura.PDF.file      = loader->file;
+      Zathura.PDF.mtime     = Zathura.Stream.file ? 0 : loader->mtime;
+      Zathura.PDF.file_size = loader->file_size;
+      loader->file          = NULL;
+    }
 
-  return completion;
-}
+    g_static_mutex_lock(&(Zathura.Lock.document_lock));
+    Zathura.PDF.document = loader->document;
+    g_static_mutex_unlock(&(Zathura.Lock.document_lock));
+
+    /* rasters on disk belong to this version of the file */
+    g_free(Zathura.Disk.document);
+    Zathura.Disk.document = (loader->mtime && !Zathura.Stream.file) ?
+      document_identity(Zathura.PDF.file, loader->mtime, loader->file_size) : NULL;
+
+    Zathura.PDF.mapping         = loader->mapping;
+    Zathura.PDF.number_of_pages = loader->number_of_pages;
+    Zathura.PDF.pages           = calloc(Zathura.PDF.number_of_pages, sizeof(Page*));
+    Zathura.State.loading       = FALSE;
+
+    Zathura.Global.enable_labelmode = FALSE;
+
+    /* start page */
+    Page* page      = malloc(sizeof(Page));
+    page->id        = loader->start_page + 1;
+    page->page      = loader->page;
+    page->recording = 0;
+    g_object_get(G_OBJECT(page->page), "label", &(page->label), NULL);
+    Zathura.PDF.pages[loader->start_page] = page;
+
+    /* show document, the remaining pages are loaded afterwards */
+    if(loader->refresh)
+    {
+      Zathura.PDF.page_number = loader->start_page;
+      draw(loader->start_page);
+    }
+    else
+      set_page(loader->start_page);
 
-Completion*
-cc_export(char* input)
-{
-  /* init completion group */
-  Completion *completion = malloc(sizeof(Completion));
-  CompletionGroup* group = malloc(sizeof(CompletionGroup));
+    /* a page that has been requested while the document was loading */
+    if(Zathura.State.goto_page != -1)
+    {
+      if(Zathura.State.goto_page < Zathura.PDF.number_of_pages)
+        set_page(Zathura.State.goto_page);
+      Zathura.State.goto_page = -1;
+    }
 
-  group->value    = NULL;
-  group->next     = NULL;
-  group->elements = NULL;
+    update_status();
 
-  completion->groups = group;
+    Zathura.Thread.load_next = 0;
+    if(!Zathura.Thread.load_idle)
+      Zathura.Thread.load_idle = gdk_threads_add_idle(cb_load_pages, NULL);
+  }
 
-  /* export images */
-  CompletionElement *export_images = malloc(sizeof(CompletionElement));
-  export_images->value = "images";
-  export_images->description = "Export images";
-  export_images->next = NULL;
+  /* the file might have grown while it was parsed */
+  if(loader->id == Zathura.Thread.load_id && Zathura.Stream.file)
+  {
+    Zathura.Stream.size    = loader->size;
+    Zathura.Stream.parsing = FALSE;
 
-  /* export attachmants */
-  CompletionElement *export_attachments = malloc(sizeof(CompletionElement));
-  export_attachments->value = "attachments";
-  export_attachments->description = "Export attachments";
-  export_attachments->next = NULL;
+    struct stat information;
+    if(stat(Zathura.Stream.file, &information) == 0 && information.st_size != Zathura.Stream.size
+        && !Zathura.Stream.update)
+      Zathura.Stream.update = gdk_threads_add_timeout(STREAM_INTERVAL, cb_stream_update, NULL);
+  }
 
-  /* connect */
-  group->elements = export_attachments;
-  export_attachments->next = export_images;
+  if(loader->error)
+    g_error_free(loader->error);
+  free(loader->file);
+  g_free(loader->command);
+  g_free(loader->password);
+  free(loader);
 
-  return completion;
+  return FALSE;
 }
 
-Completion*
-cc_open(char* input)
+gboolean
+cb_load_pages(gpointer data)
 {
-  /* init completion group */
-  Completion *completion = malloc(sizeof(Completion));
-  CompletionGroup* group = malloc(sizeof(CompletionGroup));
+  if(!Zathura.PDF.document)
+    return FALSE;
 
-  group->value    = NULL;
-  group->next     = NULL;
-  group->elements = NULL;
+  /* get pages and check label mode */
+  int i;
+  for(i = 0; i < LOAD_STEP && Zathura.Thread.load_next < Zathura.PDF.number_of_pages; i++)
+    load_page(Zathura.Thread.load_next++);
 
-  completion->groups = group;
+  if(Zathura.Thread.load_next < Zathura.PDF.number_of_pages)
+    return TRUE;
 
-  /* read dir */
-  char* path        = "/";
-  char* file        = "";
-  int   file_length = 0;
+  Zathura.Thread.load_idle = 0;
 
-  /* ~ */
-  if(input[0] == '~')
-  {
-    char *file = g_strdup_printf(":open %s/%s", getenv("HOME"), input + 1);
-    gtk_entry_set_text(Zathura.UI.inputbar, file);
-    gtk_editable_set_position(GTK_EDITABLE(Zathura.UI.inputbar), -1);
-    return NULL;
-  }
+  /* set correct goto mode */
+  if(!Zathura.Global.enable_labelmode && GOTO_MODE == GOTO_LABELS)
+    Zathura.Global.goto_mode = GOTO_DEFAULT;
 
-  /* parse input string */
-  if(input && strlen(input) > 0)
-  {
-    char* path_temp = dirname(strdup(input));
-    char* file_temp = basename(strdup(input));
-    char  last_char = input[strlen(input) - 1];
+  update_status();
 
-    if( !strcmp(path_temp, "/") && !strcmp(file_temp, "/") )
-      file = "";
-    else if( !strcmp(path_temp, "/") && strcmp(file_temp, "/") && last_char != '/')
-      file = file_temp;
-    else if( !strcmp(path_temp, "/") && strcmp(file_temp, "/") && last_char == '/')
-      path = g_strdup_printf("/%s/", file_temp);
-    else if(last_char == '/')
-      path = input;
-    else
-    {
-      path = g_strdup_printf("%s/", path_temp);
-      file = file_temp;
-    }
-  }
+  return FALSE;
+}
 
-  file_length = strlen(file);
+void
+cb_release_buffer(void* data)
+{
+  Buffer* buffer = (Buffer*) data;
 
-  /* open directory */
-  GDir* dir = g_dir_open(path, 0, NULL);
-  if(!dir)
-    return NULL;
+  g_static_mutex_lock(&(Zathura.Pool.lock));
 
-  /* create element list */
-  CompletionElement *last_element = NULL;
-  char* name            = NULL;
-  int   element_counter = 0;
+  Zathura.Pool.buffers = g_list_prepend(Zathura.Pool.buffers, buffer);
+  Zathura.Pool.size   += buffer->size;
 
-  while((name = (char*) g_dir_read_name(dir)) != NULL)
+  /* the buffers that have been idle the longest are given back */
+  while(Zathura.Pool.size > ((gsize) POOL_SIZE << 20))
   {
-    char* d_name   = g_filename_display_name(name);
-    int   d_length = strlen(d_name);
-
-    if( ((file_length <= d_length) && !strncmp(file, d_name, file_length)) ||
-        (file_length == 0) )
-    {
-      CompletionElement* el = malloc(sizeof(CompletionElement));
-      el->value = g_strdup_printf("%s%s", path, d_name);
-      el->description = NULL;
-      el->next = NULL;
+    GList* last    = g_list_last(Zathura.Pool.buffers);
+    Buffer* oldest = (Buffer*) last->data;
 
-      if(element_counter++ != 0)
-        last_element->next = el;
-      else
-        group->elements = el;
+    Zathura.Pool.buffers = g_list_delete_link(Zathura.Pool.buffers, last);
+    Zathura.Pool.size   -= oldest->size;
 
-      last_element = el;
-    }
+    free(oldest->data);
+    free(oldest);
   }
 
-  g_dir_close(dir);
+  g_static_mutex_unlock(&(Zathura.Pool.lock));
+}
 
-  return completion;
+gboolean
+cb_overview_clicked(GtkWidget* widget, GdkEventButton* event, gpointer data)
+{
+  int column  = (event->x - THUMBNAIL_PADDING) / (THUMBNAIL_WIDTH + THUMBNAIL_PADDING);
+  int row     = (event->y - THUMBNAIL_PADDING) / (THUMBNAIL_HEIGHT + THUMBNAIL_PADDING);
+  int page_id = row * Zathura.Overview.columns + column;
+
+  if(column < 0 || column >= Zathura.Overview.columns || row < 0 || page_id >= Zathura.PDF.number_of_pages)
+    return FALSE;
+
+  Zathura.Overview.selected = page_id;
+
+  Argument argument;
+  argument.n = SELECT;
+  sc_navigate_overview(&argument);
+
+  return TRUE;
 }
 
-Completion*
-cc_print(char* input)
+gboolean
+cb_overview_draw(GtkWidget* widget, GdkEventExpose* expose, gpointer data)
 {
-  /* init completion group */
-  Completion *completion = malloc(sizeof(Completion));
-  CompletionGroup* group = malloc(sizeof(CompletionGroup));
+  if(!Zathura.PDF.document)
+    return FALSE;
 
-  group->value    = NULL;
-  group->next     = NULL;
-  group->elements = NULL;
+  int cell_width  = THUMBNAIL_WIDTH  + THUMBNAIL_PADDING;
+  int cell_height = THUMBNAIL_HEIGHT + THUMBNAIL_PADDING;
+  int columns     = Zathura.Overview.columns;
 
-  completion->groups = group;
-  CompletionElement *last_element = NULL;
-  int element_counter = 0;
-  int input_length = input ? strlen(input) : 0;
+  /* the workers prefer the rows that are on the screen */
+  GtkAdjustment* adjustment = gtk_scrolled_window_get_vadjustment(Zathura.UI.view);
+  double top    = gtk_adjustment_get_value(adjustment);
+  double bottom = top + gtk_adjustment_get_page_size(adjustment);
 
-  /* read printers */
-  char *current_line = NULL, current_char;
-  int count = 0;
-  FILE *fp;
+  g_atomic_int_set(&(Zathura.Overview.first), (int) (top / cell_height) * columns);
+  g_atomic_int_set(&(Zathura.Overview.last),  ((int) (bottom / cell_height) + 1) * columns - 1);
 
-  fp = popen(LIST_PRINTER_COMMAND, "r");
+  cairo_t* cairo = gdk_cairo_create(widget->window);
+  gdk_cairo_region(cairo, expose->region);
+  cairo_clip(cairo);
 
-  if(!fp)
-  {
-    free(completion);
-    free(group);
-    return NULL;
-  }
+  /* only the cells in the exposed area are drawn */
+  int first = (expose->area.y / cell_height) * columns;
+  int last  = ((expose->area.y + expose->area.height) / cell_height + 1) * columns;
 
-  while((current_char = fgetc(fp)) != EOF)
+  int page_id;
+  for(page_id = MAX(first, 0); page_id < MIN(last, Zathura.PDF.number_of_pages); page_id++)
   {
-    if(!current_line)
-      current_line = malloc(sizeof(char));
+    int x = THUMBNAIL_PADDING + (page_id % columns) * cell_width;
+    int y = THUMBNAIL_PADDING + (page_id / columns) * cell_height;
 
-    current_line = realloc(current_line, (count + 1) * sizeof(char));
+    Thumbnail* thumbnail = g_hash_table_lookup(Zathura.Overview.thumbnails, GINT_TO_POINTER(page_id));
 
-    if(current_char != '\n')
-      current_line[count++] = current_char;
-    else
+    if(thumbnail)
     {
-      current_line[count] = '\0';
-      int line_length = strlen(current_line);
+      thumbnail->last_used = ++Zathura.Overview.clock;
 
-      if( (input_length <= line_length) ||
-          (!strncmp(input, current_line, input_length)) )
-      {
-        CompletionElement* el = malloc(sizeof(CompletionElement));
-        el->value       = g_strdup(current_line);
-        el->description = NULL;
-        el->next        = NULL;
+      int width  = cairo_image_surface_get_width(thumbnail->surface);
+      int height = cairo_image_surface_get_height(thumbnail->surface);
 
-        if(element_counter++ != 0)
-          last_element->next = el;
-        else
-          group->elements = el;
+      cairo_save(cairo);
+      cairo_translate(cairo, x + (THUMBNAIL_WIDTH - width) / 2, y + (THUMBNAIL_HEIGHT - height) / 2);
+      paint_surface(cairo, thumbnail->surface);
+      cairo_restore(cairo);
+    }
+    else
+    {
+      cairo_set_source_rgb(cairo, 0.5, 0.5, 0.5);
+      cairo_rectangle(cairo, x + 0.5, y + 0.5, THUMBNAIL_WIDTH - 1, THUMBNAIL_HEIGHT - 1);
+      cairo_stroke(cairo);
 
-        last_element = el;
-      }
+      request_thumbnail(page_id);
+    }
 
-      free(current_line);
-      current_line = NULL;
-      count = 0;
+    if(page_id == Zathura.Overview.selected)
+    {
+      GdkColor* color = &(Zathura.Style.statusbar_fg);
+      cairo_set_source_rgb(cairo, color->red / 65535.0, color->green / 65535.0, color->blue / 65535.0);
+      cairo_set_line_width(cairo, 3);
+      cairo_rectangle(cairo, x - 2, y - 2, THUMBNAIL_WIDTH + 4, THUMBNAIL_HEIGHT + 4);
+      cairo_stroke(cairo);
+      cairo_set_line_width(cairo, 1);
     }
   }
 
-  pclose(fp);
+  cairo_destroy(cairo);
 
-  return completion;
+  return TRUE;
 }
 
-Completion*
-cc_set(char* input)
+gboolean
+cb_prefetch(gpointer data)
 {
-  /* init completion group */
-  Completion *completion = malloc(sizeof(Completion));
-  CompletionGroup* group = malloc(sizeof(CompletionGroup));
+  Zathura.Cache.prefetch = 0;
 
-  group->value    = NULL;
-  group->next     = NULL;
-  group->elements = NULL;
+  /* nothing is rendered ahead while memory is short */
+  if(!Zathura.PDF.document || Zathura.Pressure.active)
+    return FALSE;
 
-  completion->groups = group;
-  CompletionElement *last_element = NULL;
-  int element_counter = 0;
-  int i = 0;
-  int input_length = input ? strlen(input) : 0;
+  /* the time the reader spends on a page, long breaks do not count */
+  if(Zathura.PDF.page_number != Zathura.Costs.last_page)
+  {
+    double elapsed = g_timer_elapsed(Zathura.Costs.timer, NULL);
+    if(Zathura.Costs.last_page != -1 && elapsed < READING_PAUSE / 1000.0)
+      Zathura.Costs.interval = (Zathura.Costs.interval * 3 + elapsed) / 4;
 
-  for(i = 0; i < LENGTH(settings); i++)
+    Zathura.Costs.last_page = Zathura.PDF.page_number;
+    g_timer_start(Zathura.Costs.timer);
+  }
+
+  /* the pages of the next spread, and during a presentation those of the
+   * previous one as well */
+  int* pages          = malloc(sizeof(int) * 2 * (MAX(PREFETCH_DEPTH, 1) + 1));
+  int number_of_pages = 0;
+
+  int left, right;
+  spread_pages(Zathura.PDF.page_number, &left, &right);
+
+  int next     = ((right != -1) ? right : left) + 1;
+  int previous = left - 1;
+
+  /* spreads further ahead are rendered now if they would not be ready by
+   * the time the reader gets there, as long as they take at most half of
+   * the cache */
+  gsize budget = (gsize) MAX(Zathura.Cache.size, 0) << 19;
+  gsize size   = 0;
+
+  int distance;
+  for(distance = 1; distance <= MAX(PREFETCH_DEPTH, 1) && next < Zathura.PDF.number_of_pages; distance++)
   {
-    if( (input_length <= strlen(settings[i].name)) &&
-          !strncmp(input, settings[i].name, input_length) )
+    spread_pages(next, &left, &right);
+
+    load_page(left);
+    if(right != -1)
+      load_page(right);
+
+    double cost = predict_cost(left) + ((right != -1) ? predict_cost(right) : 0);
+
+    if(distance == 1 || cost >= (distance - 1) * Zathura.Costs.interval)
     {
-      CompletionElement* el = malloc(sizeof(CompletionElement));
-      el->value = settings[i].name;
-      el->description = settings[i].description;
-      el->next = NULL;
+      double width, height;
+      get_view_size(left, &width, &height);
 
-      if(element_counter++ != 0)
-        last_element->next = el;
-      else
-        group->elements = el;
+      size += (gsize) cairo_format_stride_for_width(CAIRO_FORMAT_RGB24, width) * (int) height;
+      if(distance > 1 && size > budget)
+        break;
 
-      last_element = el;
+      pages[number_of_pages++] = left;
+      if(right != -1)
+        pages[number_of_pages++] = right;
     }
+
+    next = ((right != -1) ? right : left) + 1;
   }
 
-  return completion;
+  if(Zathura.Presentation.active && previous >= 0)
+  {
+    spread_pages(previous, &left, &right);
+    pages[number_of_pages++] = left;
+    if(right != -1)
+      pages[number_of_pages++] = right;
+  }
+
+  /* during a presentation the neighbours are kept like visible pages, so
+   * that changing the slide never has to wait for poppler; otherwise they
+   * are only rendered if they fit without dropping anything more important */
+  int priority = Zathura.Presentation.active ? PRIORITY_VISIBLE : PRIORITY_PREFETCH;
+
+  int i;
+  for(i = 0; i < number_of_pages; i++)
+    request_prefetch(pages[i], priority, priority);
+
+  free(pages);
+
+  return FALSE;
 }
 
-/* buffer command implementation */
-void 
-bcmd_goto(char* buffer, Argument* argument)
+gboolean
+cb_prerender_jumps(gpointer data)
 {
-  int b_length = strlen(buffer);
-  if(b_length < 1)
-    return;
+  Zathura.Cache.jumps = 0;
 
-  if(!strcmp(buffer, "gg"))
-    set_page(0);
-  else if(!strcmp(buffer, "G"))
-    set_page(Zathura.PDF.number_of_pages - 1);
-  else
+  if(!Zathura.PDF.document || Zathura.Pressure.active || JUMP_TARGETS < 1)
+    return FALSE;
+
+  int* targets        = malloc(sizeof(int) * JUMP_TARGETS);
+  int number_of_pages = 0;
+
+  /* the page of '' first, then the internal links of this page */
+  add_jump_target(targets, &number_of_pages, Zathura.Marker.last);
+
+  Page* current_page = load_page(Zathura.PDF.page_number);
+
+  g_static_mutex_lock(&(Zathura.Lock.pdflib_lock));
+  GList* link_list = poppler_page_get_link_mapping(current_page->page);
+
+  GList* list;
+  for(list = link_list; list; list = g_list_next(list))
   {
-    char* id = g_strndup(buffer, b_length - 1);
-    int  pid = atoi(id);
+    PopplerAction* action = ((PopplerLinkMapping*) list->data)->action;
+    if(action->type != POPPLER_ACTION_GOTO_DEST)
+      continue;
 
-    if(Zathura.Global.goto_mode == GOTO_LABELS)
+    int page_number = action->goto_dest.dest->page_num;
+
+    if(action->goto_dest.dest->type == POPPLER_DEST_NAMED)
     {
-      int i;
-      for(i = 0; i < Zathura.PDF.number_of_pages; i++)
-        if(!strcmp(id, Zathura.PDF.pages[i]->label))
-          pid = Zathura.PDF.pages[i]->id;
+      PopplerDest* destination = poppler_document_find_dest(Zathura.PDF.document, action->goto_dest.dest->named_dest);
+      if(!destination)
+        continue;
+
+      page_number = destination->page_num;
+      poppler_dest_free(destination);
     }
-    else if(Zathura.Global.goto_mode == GOTO_OFFSET)
-      pid += Zathura.PDF.page_offset;
 
-    set_page(pid - 1);
-    g_free(id);
-   }
+    add_jump_target(targets, &number_of_pages, page_number - 1);
+  }
 
-  update_status();
-}
+  poppler_page_free_link_mapping(link_list);
+  g_static_mutex_unlock(&(Zathura.Lock.pdflib_lock));
 
-void
-bcmd_scroll(char* buffer, Argument* argument)
-{
-  int b_length = strlen(buffer);
-  if(b_length < 1)
-    return;
+  /* markers, bookmarks and both ends of the document */
+  int i;
+  for(i = 0; i < Zathura.Marker.number_of_markers; i++)
+    add_jump_target(targets, &number_of_pages, Zathura.Marker.markers[i].page);
 
-  int percentage = atoi(g_strndup(buffer, b_length - 1));
-  percentage = (percentage < 0) ? 0 : ((percentage > 100) ? 100 : percentage);
+  for(i = 0; i < Zathura.Bookmarks.number_of_bookmarks; i++)
+    add_jump_target(targets, &number_of_pages, Zathura.Bookmarks.bookmarks[i].page);
 
-  GtkAdjustment *adjustment = gtk_scrolled_window_get_vadjustment(Zathura.UI.view);
+  add_jump_target(targets, &number_of_pages, 0);
+  add_jump_target(targets, &number_of_pages, Zathura.PDF.number_of_pages - 1);
 
-  gdouble view_size  = gtk_adjustment_get_page_size(adjustment);
-  gdouble max        = gtk_adjustment_get_upper(adjustment) - view_size;
-  gdouble nvalue     = (percentage * max) / 100;
+  /* they are only rendered into room that nothing else needs and are
+   * the first to go when it is needed */
+  for(i = 0; i < number_of_pages; i++)
+  {
+    int left, right;
+    spread_pages(targets[i], &left, &right);
 
-  Zathura.State.scroll_percentage = percentage;
-  gtk_adjustment_set_value(adjustment, nvalue);
-  update_status();
+    request_prefetch(left, PRIORITY_BACKGROUND, PRIORITY_BACKGROUND);
+    if(right != -1)
+      request_prefetch(right, PRIORITY_BACKGROUND, PRIORITY_BACKGROUND);
+  }
+
+  free(targets);
+
+  return FALSE;
 }
 
-void
-bcmd_zoom(char* buffer, Argument* argument)
+gboolean
+cb_prefetched(gpointer data)
 {
-  Zathura.Global.adjust_mode = ADJUST_NONE;
+  Prefetch* prefetch = (Prefetch*) data;
+  int page_id        = prefetch->page;
 
-  if(argument->n == ZOOM_IN)
+  g_hash_table_remove(Zathura.Cache.prefetching, GINT_TO_POINTER(page_id + 1));
+
+  gboolean current = page_id < Zathura.PDF.number_of_pages && Zathura.PDF.pages[page_id] &&
+    Zathura.PDF.pages[page_id]->page == prefetch->source;
+
+  /* like in get_raster, replays say nothing about poppler's cost and a page
+   * that is rendered again is recorded */
+  if(current && !prefetch->recording)
+    record_cost(page_id, prefetch->surface, prefetch->time);
+  if(current)
+    g_hash_table_insert(Zathura.Cache.rendered, GINT_TO_POINTER(page_id), GINT_TO_POINTER(TRUE));
+
+  /* the document, the zoom or the colors might have changed meanwhile */
+  if(current && prefetch->scale == Zathura.PDF.scale &&
+      prefetch->rotate == Zathura.PDF.rotate && prefetch->recolor == Zathura.Global.recolor &&
+      !Zathura.Pressure.active && !find_raster(page_id))
   {
-    if((Zathura.PDF.scale + ZOOM_STEP) <= ZOOM_MAX)
-      Zathura.PDF.scale += ZOOM_STEP;
-    else
-      Zathura.PDF.scale = ZOOM_MAX;
+    gsize size = (gsize) cairo_image_surface_get_stride(prefetch->surface) *
+      cairo_image_surface_get_height(prefetch->surface);
+
+    Zathura.Cache.clock++;
+    if(make_room(size, prefetch->priority))
+    {
+      finish_raster(page_id, prefetch->scale, prefetch->priority, prefetch->surface);
+      prefetch->surface = NULL;
+    }
   }
-  else if(argument->n == ZOOM_OUT)
+
+  free_prefetch(prefetch);
+
+  return FALSE;
+}
+
+gboolean
+cb_memory_pressure(GIOChannel* channel, GIOCondition condition, gpointer data)
+{
+  /* the trigger is gone with its cgroup */
+  if(condition & G_IO_ERR)
   {
-    if((Zathura.PDF.scale - ZOOM_STEP) >= ZOOM_MIN)
-      Zathura.PDF.scale -= ZOOM_STEP;
-    else
-      Zathura.PDF.scale = ZOOM_MIN;
+    Zathura.Pressure.watch = 0;
+    return FALSE;
   }
-  else if(argument->n == ZOOM_SPECIFIC)
-  {
-    int b_length = strlen(buffer);
-    if(b_length < 1)
-      return;
 
-    int value = atoi(g_strndup(buffer, b_length - 1));
-    if(value <= ZOOM_MIN)
-      Zathura.PDF.scale = ZOOM_MIN;
-    else if(value >= ZOOM_MAX)
-      Zathura.PDF.scale = ZOOM_MAX;
-    else
-      Zathura.PDF.scale = value;
-  }
-  else
-    Zathura.PDF.scale = 100;
+  /* io watches are not run with the gdk lock held */
+  gdk_threads_enter();
+  shed_memory();
+  gdk_threads_leave();
 
-  draw(Zathura.PDF.page_number);
-  update_status();
+  return TRUE;
 }
 
-/* special command implementation */
 gboolean
-scmd_search(char* input, Argument* argument)
+cb_poll_pressure(gpointer data)
 {
-  if(!strlen(input))
+  char* content = NULL;
+  if(!g_file_get_contents(PRESSURE_FILE, &content, NULL, NULL))
     return TRUE;
 
-  argument->data = input;
-  sc_search(argument);
+  float average = 0;
+  if(sscanf(content, "some avg10=%f", &average) == 1 && average >= PRESSURE_THRESHOLD)
+    shed_memory();
+
+  g_free(content);
 
   return TRUE;
 }
 
-/* callback implementation */
 gboolean
-cb_destroy(GtkWidget* widget, gpointer data)
+cb_pressure_relief(gpointer data)
 {
-  pango_font_description_free(Zathura.Style.font);
-
-  if(Zathura.PDF.document)
-    cmd_close(0, NULL);
-
-  /* clean up other variables */
-  g_free(Zathura.Bookmarks.file);
-
-  /* inotify */
-  if(Zathura.Inotify.fd != -1)
-    close(Zathura.Inotify.fd);
-
-  gtk_main_quit();
+  Zathura.Pressure.recover = 0;
+  Zathura.Pressure.active  = FALSE;
+  Zathura.Pressure.level   = 0;
 
-  return TRUE;
+  return FALSE;
 }
 
-gboolean cb_draw(GtkWidget* widget, GdkEventExpose* expose, gpointer data)
+gboolean
+cb_reload_file(gpointer data)
 {
-  if(!Zathura.PDF.document)
-    return FALSE;
-
-  int page_id = Zathura.PDF.page_number;
+  Zathura.Inotify.reload = 0;
 
-  if(page_id < 0 || page_id > Zathura.PDF.number_of_pages)
+  if(!Zathura.PDF.document)
     return FALSE;
 
-  gdk_window_clear(widget->window);
-  cairo_t *cairo = gdk_cairo_create(widget->window);
-
-  double page_width, page_height, width, height;
-  double scale = ((double) Zathura.PDF.scale / 100.0);
-
-  g_static_mutex_lock(&(Zathura.Lock.pdflib_lock));
-  poppler_page_get_size(Zathura.PDF.pages[page_id]->page, &page_width, &page_height);
-  g_static_mutex_unlock(&(Zathura.Lock.pdflib_lock));
-
-  if(Zathura.PDF.rotate == 0 || Zathura.PDF.rotate == 180)
-  {
-    width  = page_width  * scale;
-    height = page_height * scale;
-  }
-  else
-  {
-    width  = page_height * scale;
-    height = page_width  * scale;
-  }
-
-  int window_x, window_y;
-  gdk_drawable_get_size(widget->window, &window_x, &window_y);
-
-  int offset_x, offset_y;
-
-  if (window_x > width)
-    offset_x = (window_x - width) / 2;
-  else
-    offset_x = 0;
+  /* save old information, the page is restored from the bookmark entry
+   * that is written on close */
+  char* path     = g_strdup(Zathura.PDF.file);
+  char* password = Zathura.PDF.password ? g_strdup(Zathura.PDF.password) : NULL;
+  int scale      = Zathura.PDF.scale;
 
-  if (window_y > height)
-    offset_y = (window_y - height) / 2;
-  else
-    offset_y = 0;
+  /* reopen and restore settings */
+  cmd_close(0, NULL);
 
+  if(open_file(path, password))
+    Zathura.PDF.scale = scale;
 
-  cairo_set_source_surface(cairo, Zathura.PDF.surface, offset_x, offset_y);
-  cairo_paint(cairo);
-  cairo_destroy(cairo);
+  g_free(path);
+  g_free(password);
 
-  return TRUE;
+  return FALSE;
 }
 
 gboolean
-cb_inputbar_kb_pressed(GtkWidget *widget, GdkEventKey *event, gpointer data)
+cb_server_accept(GIOChannel* channel, GIOCondition condition, gpointer data)
 {
-  /* when the return button is pressed the inputbar is activated,
-   * so we do not handle it here */
-  if(event->keyval == GDK_Return)
-    return FALSE;
-
-  int i;
+  int fd = accept(Zathura.Server.fd, NULL, NULL);
+  if(fd == -1)
+    return TRUE;
 
-  /* inputbar shortcuts */
-  for(i = 0; i < LENGTH(inputbar_shortcuts); i++)
-  {
-    if(event->keyval == inputbar_shortcuts[i].key &&
-      (((event->state & inputbar_shortcuts[i].mask) == inputbar_shortcuts[i].mask)
-       || inputbar_shortcuts[i].mask == 0))
-    {
-      inputbar_shortcuts[i].function(&(inputbar_shortcuts[i].argument));
-      return TRUE;
-    }
-  }
+  GIOChannel* client = g_io_channel_unix_new(fd);
+  g_io_channel_set_close_on_unref(client, TRUE);
+  g_io_channel_set_encoding(client, NULL, NULL);
+  g_io_channel_set_flags(client, G_IO_FLAG_NONBLOCK, NULL);
 
-  /* special commands */
-  char identifier = gtk_editable_get_chars(GTK_EDITABLE(Zathura.UI.inputbar), 0, 1)[0];
-  for(i = 0; i < LENGTH(special_commands); i++)
-  {
-    if((identifier == special_commands[i].identifier) &&
-       (special_commands[i].always == 1))
-    {
-      gchar *input  = gtk_editable_get_chars(GTK_EDITABLE(Zathura.UI.inputbar), 1, -1);
-      special_commands[i].function(input, &(special_commands[i].argument));
-      return FALSE;
-    }
-  }
+  /* the watch holds the only reference to the client */
+  g_io_add_watch(client, G_IO_IN | G_IO_HUP | G_IO_ERR, cb_server_read, NULL);
+  g_io_channel_unref(client);
 
-  return FALSE;
+  return TRUE;
 }
 
 gboolean
-cb_inputbar_activate(GtkEntry* entry, gpointer data)
+cb_server_read(GIOChannel* channel, GIOCondition condition, gpointer data)
 {
-  gchar  *input  = gtk_editable_get_chars(GTK_EDITABLE(entry), 1, -1);
-  gchar **tokens = g_strsplit(input, " ", -1);
-  gchar *command = tokens[0];
-  int     length = g_strv_length(tokens);
-  int          i = 0;
-  gboolean  retv = FALSE;
-  gboolean  succ = FALSE;
+  gchar* line = NULL;
+  GIOStatus status;
 
-  /* no input */
-  if(length < 1)
+  while((status = g_io_channel_read_line(channel, &line, NULL, NULL, NULL)) == G_IO_STATUS_NORMAL)
   {
-    isc_abort(NULL);
-    return FALSE;
-  }
+    gchar **tokens = g_strsplit(g_strchomp(line), " ", -1);
+    int     length = g_strv_length(tokens);
+    gboolean  succ = FALSE;
 
-  /* append input to the command history */
-  Zathura.Global.history = g_list_append(Zathura.Global.history, g_strdup(gtk_entry_get_text(entry)));
+    /* io watches are not run with the gdk lock held, but commands touch
+     * the widgets */
+    gdk_threads_enter();
 
-  /* special commands */
-  char identifier = gtk_editable_get_chars(GTK_EDITABLE(entry), 0, 1)[0];
-  for(i = 0; i < LENGTH(special_commands); i++)
-  {
-    if(identifier == special_commands[i].identifier)
+    /* search commands */
+    int i;
+    for(i = 0; i < LENGTH(commands) && length > 0; i++)
     {
-      /* special commands that are evaluated every key change are not
-       * called here */
-      if(special_commands[i].always == 1)
+      if((g_strcmp0(tokens[0], commands[i].command) == 0) ||
+         (g_strcmp0(tokens[0], commands[i].abbr)    == 0))
       {
-        isc_abort(NULL);
-        return TRUE;
+        commands[i].function(length - 1, tokens + 1);
+        succ = TRUE;
+        break;
       }
-
-      retv = special_commands[i].function(input, &(special_commands[i].argument));
-      if(retv) isc_abort(NULL);
-      gtk_widget_grab_focus(GTK_WIDGET(Zathura.UI.view));
-      return TRUE;
-    }
-  }
-
-  /* search commands */
-  for(i = 0; i < LENGTH(commands); i++)
-  {
-    if((g_strcmp0(command, commands[i].command) == 0) ||
-       (g_strcmp0(command, commands[i].abbr)    == 0))
-    {
-      retv = commands[i].function(length - 1, tokens + 1);
-      succ = TRUE;
-      break;
     }
-  }
 
-  if(retv)
-    isc_abort(NULL);
+    if(!succ && length > 0)
+      notify(ERROR, "Unknown command.");
 
-  if(!succ)
-    notify(ERROR, "Unknown command.");
+    gtk_window_present(Zathura.UI.window);
+    gdk_threads_leave();
 
-  Argument arg = { HIDE };
-  isc_completion(&arg);
-  gtk_widget_grab_focus(GTK_WIDGET(Zathura.UI.view));
+    g_strfreev(tokens);
+    g_free(line);
+  }
 
-  return TRUE;
+  /* keep reading until the client has sent everything */
+  return (status == G_IO_STATUS_AGAIN);
 }
 
-gboolean
-cb_inputbar_form_activate(GtkEntry* entry, gpointer data)
+cairo_status_t
+cb_write_png(void* closure, const unsigned char* data, unsigned int length)
 {
-  if(!Zathura.PDF.document)
-    return TRUE;
+  g_byte_array_append((GByteArray*) closure, data, length);
 
-  Page* current_page = Zathura.PDF.pages[Zathura.PDF.page_number];
-  int number_of_links = 0, link_id = 1, new_page_id = Zathura.PDF.page_number;
+  return CAIRO_STATUS_SUCCESS;
+}
 
-  g_static_mutex_lock(&(Zathura.Lock.pdflib_lock));
-  GList *link_list = poppler_page_get_link_mapping(current_page->page);
-  g_static_mutex_unlock(&(Zathura.Lock.pdflib_lock));
-  link_list = g_list_reverse(link_list);
+gboolean
+cb_stream_update(gpointer data)
+{
+  Zathura.Stream.update = 0;
 
-  if((number_of_links = g_list_length(link_list)) <= 0)
+  if(!Zathura.Stream.file || Zathura.Stream.parsing)
     return FALSE;
 
-  /* parse entry */
-  gchar *input = gtk_editable_get_chars(GTK_EDITABLE(entry), 1, -1);
-  gchar *token = input + strlen("Follow hint: ") - 1;
-  if(!token)
+  /* parse again only if new data has arrived */
+  struct stat information;
+  if(stat(Zathura.Stream.file, &information) != 0 || information.st_size == Zathura.Stream.size)
     return FALSE;
 
-  int li = atoi(token);
-  if(li <= 0 || li > number_of_links)
-  {
-    set_page(Zathura.PDF.page_number);
-    isc_abort(NULL);
-    notify(WARNING, "Invalid hint");
-    return TRUE;
-  }
+  if(Zathura.PDF.document)
+    start_loader(Zathura.Stream.file, Zathura.Stream.password, Zathura.PDF.page_number, TRUE);
+  else
+    start_loader(Zathura.Stream.file, Zathura.Stream.password, 0, FALSE);
 
-  /* compare entry */
-  GList *links;
-  for(links = link_list; links; links = g_list_next(links))
+  return FALSE;
+}
+
+gboolean
+cb_thumbnail_ready(gpointer data)
+{
+  Thumbnail* thumbnail = (Thumbnail*) data;
+
+  if(thumbnail->generation != g_atomic_int_get(&(Zathura.Overview.generation)))
   {
-    PopplerLinkMapping *link_mapping = (PopplerLinkMapping*) links->data;
-    PopplerAction            *action = link_mapping->action;
+    free_thumbnail(thumbnail);
+    return FALSE;
+  }
 
-    /* only handle URI and internal links */
-    if(action->type == POPPLER_ACTION_URI)
-    {
-      if(li == link_id)
-        open_uri(action->uri.uri);
-    }
-    else if(action->type == POPPLER_ACTION_GOTO_DEST)
-    {
-      if(li == link_id)
-      {
-        if(action->goto_dest.dest->type == POPPLER_DEST_NAMED)
-        {
-          PopplerDest* destination = poppler_document_find_dest(Zathura.PDF.document, action->goto_dest.dest->named_dest);
-          if(destination)
-          {
-            new_page_id = destination->page_num - 1;
-            poppler_dest_free(destination);
-          }
-        }
-        else
-          new_page_id = action->goto_dest.dest->page_num - 1;
-      }
-    }
-    else
-      continue;
+  g_hash_table_remove(Zathura.Overview.queued, GINT_TO_POINTER(thumbnail->page + 1));
 
-    link_id++;
+  /* a skipped page is requested again when it is drawn */
+  if(!thumbnail->surface)
+  {
+    free_thumbnail(thumbnail);
+    return FALSE;
   }
 
-  poppler_page_free_link_mapping(link_list);
+  trim_thumbnails(thumbnail->size);
 
-  /* replace default inputbar handler */
-  g_signal_handler_disconnect((gpointer) Zathura.UI.inputbar, Zathura.Handler.inputbar_activate);
-  Zathura.Handler.inputbar_activate = g_signal_connect(G_OBJECT(Zathura.UI.inputbar), "activate", G_CALLBACK(cb_inputbar_activate), NULL);
+  thumbnail->last_used   = ++Zathura.Overview.clock;
+  Zathura.Overview.used += thumbnail->size;
+  g_hash_table_insert(Zathura.Overview.thumbnails, GINT_TO_POINTER(thumbnail->page), thumbnail);
 
-  /* reset all */
-  set_page(new_page_id);
-  isc_abort(NULL);
+  int x = THUMBNAIL_PADDING + (thumbnail->page % Zathura.Overview.columns) * (THUMBNAIL_WIDTH + THUMBNAIL_PADDING);
+  int y = THUMBNAIL_PADDING + (thumbnail->page / Zathura.Overview.columns) * (THUMBNAIL_HEIGHT + THUMBNAIL_PADDING);
+  gtk_widget_queue_draw_area(Zathura.UI.overview, x, y, THUMBNAIL_WIDTH, THUMBNAIL_HEIGHT);
 
-  return TRUE;
+  return FALSE;
 }
 
 gboolean
@@ -3267,6 +8602,9 @@ cb_view_kb_pressed(GtkWidget *widget, GdkEventKey *event, gpointer data)
 gboolean
 cb_view_resized(GtkWidget* widget, GtkAllocation* allocation, gpointer data)
 {
+  if(Zathura.Overview.visible)
+    layout_overview();
+
   Argument arg;
   arg.n = Zathura.Global.adjust_mode;
   sc_adjust_window(&arg);
@@ -3275,20 +8613,146 @@ cb_view_resized(GtkWidget* widget, GtkAllocation* allocation, gpointer data)
 }
 
 
+gboolean
+cb_watch_file(GIOChannel* channel, GIOCondition condition, gpointer data)
+{
+  char buffer[INOTIFY_BUFFER] __attribute__((aligned(__alignof__(struct inotify_event))));
+  gboolean changed = FALSE;
+  gboolean grown   = FALSE;
+  ssize_t length;
+
+  /* drain all pending events, an event carries a name of variable length */
+  while((length = read(Zathura.Inotify.fd, buffer, sizeof(buffer))) > 0)
+  {
+    char* position = buffer;
+
+    while(position < buffer + length)
+    {
+      struct inotify_event *event = (struct inotify_event*) position;
+
+      if((event->wd == Zathura.Inotify.wd) && (event->mask & IN_CLOSE_WRITE))
+        changed = TRUE;
+      else if((event->wd == Zathura.Inotify.wd) && (event->mask & IN_MODIFY))
+        grown = TRUE;
+
+      position += sizeof(struct inotify_event) + event->len;
+    }
+  }
+
+  /* a streamed file is parsed again at most every STREAM_INTERVAL ms */
+  if(Zathura.Stream.file)
+  {
+    if((changed || grown) && !Zathura.Stream.update)
+      Zathura.Stream.update = gdk_threads_add_timeout(STREAM_INTERVAL, cb_stream_update, NULL);
+  }
+  /* several writes in a row lead to exactly one reload */
+  else if(changed && !Zathura.Inotify.reload)
+    Zathura.Inotify.reload = gdk_threads_add_idle(cb_reload_file, NULL);
+
+  return TRUE;
+}
+
 /* main function */
 int main(int argc, char* argv[])
 {
   g_thread_init(NULL);
   gdk_threads_init();
 
+  /* every mode renders into pooled buffers */
+  init_pool();
+
+  /* command line options */
+  gboolean stream        = FALSE;
+  gboolean server        = FALSE;
+  gboolean render_daemon = FALSE;
+  gboolean render_client = FALSE;
+  char*    command       = NULL;
+  char*    render_file   = NULL;
+  char*    render_pages  = NULL;
+  char*    render_out    = ".";
+  int      render_scale  = 100;
+  int      render_rotate = 0;
+
+  GOptionEntry options[] =
+  {
+    { "stream",  's', 0, G_OPTION_ARG_NONE,   &stream,  "Follow a document that is still being written", NULL },
+    { "server",  'x', 0, G_OPTION_ARG_NONE,   &server,  "Pass the arguments on to a running instance", NULL },
+    { "command", 'c', 0, G_OPTION_ARG_STRING, &command, "Execute a command after opening the file", "COMMAND" },
+    { "daemon",  'd', 0, G_OPTION_ARG_NONE,   &render_daemon, "Serve page rasters on a socket without a window", NULL },
+    { "render",  0,   0, G_OPTION_ARG_FILENAME, &render_file,   "Render pages of FILE to PNG files without a window", "FILE" },
+    { "client",  0,   0, G_OPTION_ARG_NONE,     &render_client, "Have the render daemon render the pages", NULL },
+    { "pages",   0,   0, G_OPTION_ARG_STRING,   &render_pages,  "Pages to render, e.g. 1-10,12", "RANGE" },
+    { "scale",   0,   0, G_OPTION_ARG_INT,      &render_scale,  "Scale in percent", "SCALE" },
+    { "rotate",  0,   0, G_OPTION_ARG_INT,      &render_rotate, "Rotation in degrees", "ROTATION" },
+    { "out",     0,   0, G_OPTION_ARG_FILENAME, &render_out,    "Directory for the rendered pages", "DIRECTORY" },
+    { NULL }
+  };
+
+  /* the display is only opened if no running instance takes over */
+  GError* error           = NULL;
+  GOptionContext* context = g_option_context_new("[FILE] [PASSWORD]");
+  g_option_context_add_main_entries(context, options, NULL);
+  g_option_context_add_group(context, gtk_get_option_group(FALSE));
+
+  if(!g_option_context_parse(context, &argc, &argv, &error))
+  {
+    fprintf(stderr, "zathura: %s\n", error->message);
+    return 1;
+  }
+
+  g_option_context_free(context);
+
+  /* the render daemon needs no widgets */
+  if(render_daemon)
+    return run_daemon();
+
+  if(render_file && render_client)
+    return run_client(render_file, render_pages, render_scale, render_rotate, render_out);
+
+  if(render_file)
+    return run_batch(render_file, render_pages, render_scale, render_rotate, render_out);
+
+  /* a password is not passed on to the running instance */
+  if(server && argc < 3)
+  {
+    int status = send_to_server((argc == 2) ? argv[1] : NULL, command);
+    if(status != -1)
+      return status;
+  }
+
   gtk_init(&argc, &argv);
 
   init_zathura();
   init_directories();
 
+  if(stream)
+    Zathura.Global.stream = TRUE;
+
+  if(server)
+    start_server();
+
   if(argc >= 2)
     open_file(argv[1], (argc == 3) ? argv[2] : NULL);
 
+  if(command)
+  {
+    gchar **tokens = g_strsplit(command, " ", -1);
+    int     length = g_strv_length(tokens);
+
+    int i;
+    for(i = 0; i < LENGTH(commands) && length > 0; i++)
+    {
+      if((g_strcmp0(tokens[0], commands[i].command) == 0) ||
+         (g_strcmp0(tokens[0], commands[i].abbr)    == 0))
+      {
+        commands[i].function(length - 1, tokens + 1);
+        break;
+      }
+    }
+
+    g_strfreev(tokens);
+  }
+
   update_status();
 
   gtk_widget_show_all(GTK_WIDGET(Zathura.UI.window));